@@ -0,0 +1,135 @@
+/*
+ *  Adaptive sampling rate for the testbed
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include "adaptive.h"
+
+//***************************************************************
+// Variables and definitions					*
+//***************************************************************
+	#define	ALPHA		0.3	// weight of a new sample in the deviation
+	#define	QUIET		0.5	// activity below which the interval grows
+	#define	MAX_STEP	16.0	// largest division of the interval by a change
+	#define	RESERVE		10	// samples of energy that can be saved
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	adaptiveSampler::adaptiveSampler(uint32_t minInterval, uint32_t maxInterval)
+		: minInterval(minInterval), maxInterval(maxInterval), interval(minInterval),
+		panelRate(5.0), panelDeviation(50.0), windRate(0.5), windDeviation(1.5),
+		sampleEnergy(0.0), budgetPower(0.0), tokens(0.0), started(false), last(0),
+		lastPanel(NAN), panelSlope(0.0), panelVariance(0.0),
+		lastWind(NAN), windSlope(0.0), windVariance(0.0)
+	{
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	void adaptiveSampler::setPanelThreshold(float rate, float deviation)
+	{
+		panelRate = rate;
+		panelDeviation = deviation;
+	}
+
+	void adaptiveSampler::setWindThreshold(float rate, float deviation)
+	{
+		windRate = rate;
+		windDeviation = deviation;
+	}
+
+	void adaptiveSampler::setBudget(float energy, float power)
+	{
+		sampleEnergy = energy;
+		budgetPower = power;
+		tokens = RESERVE * energy;
+	}
+
+	//!******************************************************************************
+	//!	Name:	update()							*
+	//!	Description: Accounts a sample and returns the interval until the	*
+	//!	next one: shortened while a signal changes, grown by a quarter while	*
+	//!	both are quiet, and stretched if the energy budget is exhausted.	*
+	//!	Param : time of the sample (ms), panel power (mW), wind (m/s)		*
+	//!	Returns: uint32_t with the interval (ms)				*
+	//!	Example: delay(sampler.update(millis(), s.panelPower, s.windSpeed));	*
+	//!******************************************************************************
+	uint32_t adaptiveSampler::update(uint32_t now, float panelPower, float windSpeed)
+	{
+		float dt, score;
+
+		if (!started){
+			started = true;
+			last = now;
+			activity(panelPower, 0, lastPanel, panelSlope, panelVariance, panelRate, panelDeviation);
+			activity(windSpeed, 0, lastWind, windSlope, windVariance, windRate, windDeviation);
+			interval = minInterval;
+			tokens -= sampleEnergy;
+			return interval;
+		}
+		dt = (now - last) / 1000.0;
+		last = now;
+		score = activity(panelPower, dt, lastPanel, panelSlope, panelVariance, panelRate, panelDeviation);
+		score = fmaxf(score, activity(windSpeed, dt, lastWind, windSlope, windVariance, windRate, windDeviation));
+
+		if (score > 1.0){
+			// The stronger the change the faster the rate rises
+			interval /= (score < MAX_STEP) ? (score < 2.0 ? 2.0 : score) : MAX_STEP;
+			if (interval < minInterval){
+				interval = minInterval;
+			}
+		}else if (score < QUIET){
+			interval += (interval / 4 > 0) ? interval / 4 : 1;
+			if (interval > maxInterval){
+				interval = maxInterval;
+			}
+		}
+
+		// Energy earned since the last sample, minus what this one spent
+		if (budgetPower > 0){
+			tokens = fminf(tokens + budgetPower * dt, RESERVE * sampleEnergy) - sampleEnergy;
+			if (tokens < 0 and -tokens / budgetPower * 1000.0 > interval){
+				return (uint32_t)(-tokens / budgetPower * 1000.0);
+			}
+		}
+		return interval;
+	}
+
+	uint32_t adaptiveSampler::getInterval(void)
+	{
+		return interval;
+	}
+
+//***************************************************************
+// Private Methods						*
+//***************************************************************
+
+	//! This function will compare a signal with the value expected following
+	// the trend of the last two samples. It returns the largest of its rate of
+	// change and of the deviation from the trend over their thresholds
+	float adaptiveSampler::activity(float value, float dt, float &lastValue, float &slope, float &variance, float rate, float deviation)
+	{
+		float score = 0.0;
+		float residual;
+
+		if (isnan(value)){
+			return score;
+		}
+		if (isnan(lastValue) or dt <= 0){
+			lastValue = value;
+			slope = variance = 0.0;
+			return score;
+		}
+		residual = value - (lastValue + slope * dt);
+		variance = (1.0 - ALPHA) * variance + ALPHA * residual * residual;
+		slope = (value - lastValue) / dt;
+		lastValue = value;
+		score = fabsf(slope) / rate;
+		return fmaxf(score, sqrtf(variance) / deviation);
+	}
@@ -0,0 +1,66 @@
+/*
+ *  Adaptive sampling rate for the testbed
+ *
+ *  Chooses the interval until the next sample from the panel power
+ *  and the speed of the wind just read. When either signal changes
+ *  faster than its rate threshold, or deviates from the trend of the
+ *  previous samples more than its deviation threshold (a running
+ *  variance), the interval is divided by how much the threshold is
+ *  exceeded, at least by two (down to the minimum). When both are
+ *  quiet it grows by a quarter (up to the maximum). An optional
+ *  energy budget stretches the interval when sampling would spend
+ *  more than the power allowed; the budget wins over the maximum
+ *  interval.
+ *
+ *  It does not use the hardware, so recorded traces can be replayed
+ *  on a host (tools/dataset/adaptreplay.cpp).
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef adaptiveSampler_h
+#define adaptiveSampler_h
+
+#include <stdint.h>
+
+class adaptiveSampler {
+	uint32_t minInterval;		// ms
+	uint32_t maxInterval;		// ms
+	uint32_t interval;		// ms, current
+	float panelRate;		// mW/s considered a change
+	float panelDeviation;		// mW considered a change
+	float windRate;			// m/s per s considered a change
+	float windDeviation;		// m/s considered a change
+	float sampleEnergy;		// mJ spent by a sample
+	float budgetPower;		// mW allowed for sampling, 0 without budget
+	float tokens;			// mJ saved for the next samples
+	bool started;
+	uint32_t last;			// ms of the previous sample
+	float lastPanel, panelSlope, panelVariance;
+	float lastWind, windSlope, windVariance;
+
+	//! Activity of a signal: > 1 if it changes, NAN values are ignored
+	float activity(float value, float dt, float &lastValue, float &slope, float &variance, float rate, float deviation);
+	public:
+		//! Creates a sampler between the given intervals (ms)
+		adaptiveSampler(uint32_t minInterval, uint32_t maxInterval);
+
+		//! Sets what a change of the panel power is: mW/s and mW
+		void setPanelThreshold(float rate, float deviation);
+
+		//! Sets what a change of the wind is: m/s per s and m/s
+		void setWindThreshold(float rate, float deviation);
+
+		//! Sets the energy of a sample (mJ) and the power for sampling (mW)
+		void setBudget(float sampleEnergy, float power);
+
+		//! Accounts a sample taken at now (ms) and returns the next interval (ms)
+		uint32_t update(uint32_t now, float panelPower, float windSpeed);
+
+		//! Returns the current interval (ms)
+		uint32_t getInterval(void);
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ *  Adaptive data rate (ADR) of the LoRa uplink
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include "adr.h"
+
+// mA drawn by the SX1276 (PA_BOOST) transmitting at each level. The
+// datasheet gives 120 mA at +20 dBm and 87 mA at +17 dBm; the lower
+// levels are extrapolated
+static const float adrCurrent[ADR_LEVELS] = {125.0, 120.0, 87.0, 60.0, 45.0, 36.0, 30.0};
+
+int8_t adrPower(uint8_t level)
+{
+	return ADR_MAX_POWER - level * ADR_POWER_STEP;
+}
+
+float adrEnergy(uint8_t rate, uint8_t level, uint8_t bytes)
+{
+	const loraRate &r = adrRates[rate];
+
+	// us * mA * V = nJ
+	return loraAirtime(bytes, r.sf, r.bandwidth, r.cr) * adrCurrent[level] * ADR_VOLTAGE / 1000000.0;
+}
+
+//! Returns the SNR (dB) the setting needs at 125 kHz: a wider band has more noise
+static float adrRequired(uint8_t rate)
+{
+	return adrRates[rate].floor + 10 * log10f(adrRates[rate].bandwidth / 125000.0);
+}
+
+//! Returns the probability that a frame and its acknowledgement (sent at the
+// highest power) are received, for a link (dB) with a gaussian fading
+static float adrDelivery(float link, float deviation, uint8_t rate, uint8_t level)
+{
+	float up = 0.5 * erfcf((adrRequired(rate) + level * ADR_POWER_STEP - link) / (deviation * M_SQRT2));
+	float down = 0.5 * erfcf((adrRequired(rate) - link) / (deviation * M_SQRT2));
+
+	return up * down;
+}
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	adrController::adrController(void) : rate(ADR_DEFAULT), level(0), slowest(0), fastest(ADR_RATES - 1), count(0), next(0), misses(0)
+	{
+	}
+
+	adrStats::adrStats(void)
+	{
+		memset(settings, 0, sizeof(settings));
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	void adrController::allowRates(bool allow)
+	{
+		slowest = allow ? 0 : ADR_DEFAULT;
+		fastest = allow ? ADR_RATES - 1 : ADR_DEFAULT;
+		if (!allow){
+			rate = ADR_DEFAULT;
+		}
+	}
+
+	void adrController::heard(float snr, uint8_t sentRate, uint8_t sentLevel)
+	{
+		if ((sentRate >= ADR_RATES) or (sentLevel >= ADR_LEVELS)){
+			return;
+		}
+		history[next] = snr + 10 * log10f(adrRates[sentRate].bandwidth / 125000.0) + sentLevel * ADR_POWER_STEP;
+		next = (next + 1) % ADR_HISTORY;
+		if (count < ADR_HISTORY){
+			count++;
+		}
+		misses = 0;
+	}
+
+	bool adrController::missed(void)
+	{
+		bool back = (rate != slowest) or (level != 0);
+
+		if (++misses < ADR_MISSES){
+			return false;
+		}
+		rate = slowest;
+		level = 0;
+		count = 0;
+		next = 0;
+		misses = 0;
+		return back;
+	}
+
+	//!******************************************************************************
+	//!	Name:	decide()							*
+	//!	Description: With ADR_HISTORY measures, moves to the setting with the	*
+	//!	least energy per frame delivered among those that deliver at least	*
+	//!	ADR_DELIVERY of them, given the mean and deviation of the SNR. It	*
+	//!	moves to a cheaper setting only if it is still cheaper with a link	*
+	//!	ADR_HYSTERESIS dB weaker.						*
+	//!	Param : bytes of the frames						*
+	//!	Returns: bool, true if the setting changed				*
+	//!	Example: if (adr.decide(56)) {...}					*
+	//!******************************************************************************
+	bool adrController::decide(uint8_t bytes)
+	{
+		float link = 0, deviation = 0, current;
+		uint8_t r, l;
+
+		if (count < ADR_HISTORY){
+			return false;
+		}
+		for (int i = 0; i < ADR_HISTORY; i++){
+			link += history[i];
+		}
+		link /= ADR_HISTORY;
+		for (int i = 0; i < ADR_HISTORY; i++){
+			deviation += (history[i] - link) * (history[i] - link);
+		}
+		deviation = fmaxf(sqrtf(deviation / (ADR_HISTORY - 1)), ADR_FADING);
+		current = adrDelivery(link, deviation, rate, level);
+		if (current < ADR_DELIVERY){
+			// Too many frames lost: the cheapest setting that delivers them
+			choose(link, deviation, bytes, r, l);
+		}else{
+			choose(link - ADR_HYSTERESIS, deviation, bytes, r, l);
+			if (adrEnergy(r, l, bytes) / adrDelivery(link - ADR_HYSTERESIS, deviation, r, l) >=
+					adrEnergy(rate, level, bytes) / current){
+				return false;
+			}
+		}
+		if ((r == rate) and (l == level)){
+			return false;
+		}
+		rate = r;
+		level = l;
+		return true;
+	}
+
+	void adrController::set(uint8_t rate, uint8_t level)
+	{
+		this->rate = (rate < ADR_RATES) ? rate : ADR_DEFAULT;
+		this->level = (level < ADR_LEVELS) ? level : 0;
+		misses = 0;
+	}
+
+	uint8_t adrController::getRate(void)
+	{
+		return rate;
+	}
+
+	uint8_t adrController::getLevel(void)
+	{
+		return level;
+	}
+
+	void adrStats::account(uint8_t rate, uint8_t level, uint8_t bytes, bool acked)
+	{
+		adrSetting &s = settings[rate][level];
+		const loraRate &r = adrRates[rate];
+
+		s.sent++;
+		s.airtime += loraAirtime(bytes, r.sf, r.bandwidth, r.cr) / 1000;
+		s.energy += adrEnergy(rate, level, bytes);
+		if (acked){
+			s.acked++;
+			s.bytes += bytes;
+		}
+	}
+
+	adrSetting adrStats::get(uint8_t rate, uint8_t level)
+	{
+		adrSetting none = {0, 0, 0, 0, 0};
+
+		if ((rate >= ADR_RATES) or (level >= ADR_LEVELS)){
+			return none;
+		}
+		return settings[rate][level];
+	}
+
+//***************************************************************
+// Private Methods						*
+//***************************************************************
+
+	void adrController::choose(float link, float deviation, uint8_t bytes, uint8_t &r, uint8_t &l)
+	{
+		float best = INFINITY, delivery, cost;
+
+		// Nothing delivers enough: the most robust setting at the highest power
+		r = slowest;
+		l = 0;
+		for (uint8_t i = slowest; i <= fastest; i++){
+			for (uint8_t j = 0; j < ADR_LEVELS; j++){
+				delivery = adrDelivery(link, deviation, i, j);
+				cost = adrEnergy(i, j, bytes) / delivery;
+				if ((delivery >= ADR_DELIVERY) and (cost < best)){
+					best = cost;
+					r = i;
+					l = j;
+				}
+			}
+		}
+	}
@@ -0,0 +1,129 @@
+/*
+ *  Adaptive data rate (ADR) of the LoRa uplink
+ *
+ *  The gateway measures the SNR of the frames of each node and picks,
+ *  with adrController, the modem setting (spreading factor, bandwidth
+ *  and coding rate) and TX power that deliver them with the least
+ *  energy per byte. The SNR is normalized to 125 kHz and the highest
+ *  power, so the measures taken with different settings are averaged
+ *  together; its deviation gives the frames that a setting would lose
+ *  under the demodulation floor. The setting gets more robust as soon
+ *  as it delivers less than ADR_DELIVERY, but cheaper only when it
+ *  would still be cheaper with ADR_HYSTERESIS dB less, so it does not
+ *  swing with the fading.
+ *
+ *  The gateway tells the setting to the node in the acknowledgement
+ *  of each frame. Nodes start at ADR_DEFAULT. A node that misses
+ *  ADR_MISSES acknowledgements, and the gateway that misses as many
+ *  frames of a node, fall back to the most robust setting allowed at
+ *  the highest power, so both meet again, even if the node is too far
+ *  for the default setting.
+ *
+ *  adrStats accounts the frames sent with each setting on the node.
+ *  Neither class uses the hardware, so they can be simulated on a host
+ *  (tools/radio).
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef adrController_h
+#define adrController_h
+
+#include <stdint.h>
+#include "airtime.h"
+
+#define	ADR_RATES	7	// modem settings, from the most robust
+#define	ADR_DEFAULT	5	// Bw125Cr45Sf128, the RH_RF95 default
+#define	ADR_LEVELS	7	// TX power levels, from the highest
+#define	ADR_MAX_POWER	23	// dBm of level 0
+#define	ADR_POWER_STEP	3	// dB between levels
+#define	ADR_HISTORY	8	// frames averaged
+#define	ADR_DELIVERY	0.9	// frames acknowledged at least
+#define	ADR_FADING	2.0	// dB of deviation of the SNR at least
+#define	ADR_HYSTERESIS	3.0	// dB more needed to take a cheaper setting
+#define	ADR_MISSES	3	// consecutive losses to fall back to the most robust setting
+#define	ADR_VOLTAGE	3.3	// V of the radio
+
+//! Modem setting of the SX1276
+struct loraRate {
+	uint8_t sf;			// spreading factor
+	uint32_t bandwidth;		// Hz
+	uint8_t cr;			// coding rate denominator minus 4
+	float floor;			// dB, lowest SNR demodulated (SX1276 datasheet)
+};
+
+static const loraRate adrRates[ADR_RATES] = {
+	{12, 125000, 1, -20.0},
+	{11, 125000, 1, -17.5},
+	{10, 125000, 1, -15.0},
+	{9, 125000, 1, -12.5},
+	{8, 125000, 1, -10.0},
+	{7, 125000, 1, -7.5},
+	{7, 250000, 1, -7.5},
+};
+
+//! Frames sent with a setting
+struct adrSetting {
+	uint16_t sent;			// frames
+	uint16_t acked;			// frames acknowledged
+	uint32_t bytes;			// bytes acknowledged
+	uint32_t airtime;		// ms on air
+	float energy;			// mJ of the transmissions
+};
+
+//! Returns the TX power (dBm) of a level
+int8_t adrPower(uint8_t level);
+
+//! Returns the mJ to send bytes with a setting
+float adrEnergy(uint8_t rate, uint8_t level, uint8_t bytes);
+
+class adrController {
+	uint8_t rate;			// current setting
+	uint8_t level;
+	uint8_t slowest;		// settings allowed
+	uint8_t fastest;
+	uint8_t count;			// SNR measures kept
+	uint8_t next;			// place of the next measure
+	uint8_t misses;			// consecutive frames lost
+	float history[ADR_HISTORY];	// dB, normalized to 125 kHz and level 0
+
+	//! Returns the setting with the least energy per frame delivered
+	void choose(float link, float deviation, uint8_t bytes, uint8_t &r, uint8_t &l);
+	public:
+		adrController(void);
+
+		//! Allows settings other than ADR_DEFAULT (the gateway must follow them)
+		void allowRates(bool allow);
+
+		//! Accounts the SNR (dB) of a frame received, sent with the given setting
+		void heard(float snr, uint8_t sentRate, uint8_t sentLevel);
+
+		//! Accounts a frame lost, returns true if it fell back to the most robust setting
+		bool missed(void);
+
+		//! Chooses the setting for frames of bytes, returns true if it changed
+		bool decide(uint8_t bytes);
+
+		//! Sets the setting, as told by the gateway
+		void set(uint8_t rate, uint8_t level);
+
+		//! Returns the current setting
+		uint8_t getRate(void);
+		uint8_t getLevel(void);
+};
+
+class adrStats {
+	adrSetting settings[ADR_RATES][ADR_LEVELS];
+	public:
+		adrStats(void);
+
+		//! Accounts a frame of bytes sent with a setting
+		void account(uint8_t rate, uint8_t level, uint8_t bytes, bool acked);
+
+		//! Returns the frames sent with a setting
+		adrSetting get(uint8_t rate, uint8_t level);
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ *  Time on air of a LoRa packet
+ *
+ *  Formula of the Semtech SX1276 datasheet (section 4.1.1.7) for
+ *  explicit header mode. Used to place transmissions in time slots
+ *  and to account the airtime of each modem setting. It only depends
+ *  on <stdint.h>, so the host tools share it.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef airtime_h
+#define airtime_h
+
+#include <stdint.h>
+
+//! Microseconds on air of a packet of payload bytes
+/*!
+\param uint8_t : payload bytes
+\param uint8_t : spreading factor (6-12)
+\param uint32_t : bandwidth (Hz)
+\param uint8_t : coding rate denominator minus 4 (1 for 4/5 ... 4 for 4/8)
+\param uint8_t : preamble symbols (8 by default in RadioHead)
+\return uint32_t : microseconds
+*/
+static inline uint32_t loraAirtime(uint8_t payload, uint8_t sf, uint32_t bandwidth, uint8_t cr, uint8_t preamble = 8)
+{
+	// Symbol time in microseconds
+	uint32_t symbol = ((uint32_t)1000000 << sf) / bandwidth;
+	// Low data rate optimization when the symbol lasts more than 16 ms
+	int de = (symbol > 16000) ? 1 : 0;
+	int num = 8 * payload - 4 * sf + 28 + 16;	// CRC on, explicit header
+	int den = 4 * (sf - 2 * de);
+	int symbols = 8 + ((num > 0) ? ((num + den - 1) / den) * (cr + 4) : 0);
+
+	return (preamble * 4 + 17) * symbol / 4 + symbols * symbol;
+}
+
+#endif
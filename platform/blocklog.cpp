@@ -0,0 +1,200 @@
+/*
+ *  Crash-consistent log in blocks
+ *
+ *  Version 1.0
+ */
+
+#include <string.h>
+#include "blocklog.h"
+
+uint32_t logCRC(const uint8_t *data, size_t len, uint32_t crc)
+{
+	crc = ~crc;
+	while (len--){
+		crc ^= *data++;
+		for (int i = 0; i < 8; i++){
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	blockLog::blockLog(void) : next(0), used(0), reads(0)
+	{
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	//! This function will tell if a file can be a log: an empty one, or
+	// one whose first block starts with the magic number even if torn.
+	// Like recover(), it drops the records kept in RAM
+	bool blockLog::owns(blockStore &store)
+	{
+		logHeader header;
+
+		used = 0;
+		if (store.blocks() == 0){
+			return true;
+		}
+		if (!store.readBlock(0, block)){
+			return false;
+		}
+		memcpy(&header, block, sizeof(header));
+		return header.magic == LOG_MAGIC;
+	}
+
+	//!******************************************************************************
+	//!	Name:	recover()							*
+	//!	Description: Finds the first block that is not valid. Blocks are only	*
+	//!	appended, so only the last one can be torn: if it is valid the log	*
+	//!	ends there, otherwise the first invalid block is binary searched	*
+	//!	(the valid blocks before it, the invalid ones after it). The blocks	*
+	//!	of a record torn before its last one are dropped too, so the next	*
+	//!	record is not appended to its first part, and zeroed: a shorter	*
+	//!	record written over them would leave the rest valid after it, where	*
+	//!	a later tear would end the log. The records kept in RAM are dropped.	*
+	//!	Param : blocks of the log						*
+	//!	Returns: uint32_t with the index of the next block to write		*
+	//!	Example: next = log.recover(store);					*
+	//!******************************************************************************
+	uint32_t blockLog::recover(blockStore &store)
+	{
+		uint32_t low = 0, high = store.blocks(), middle;
+
+		reads = 0;
+		if ((high > 0) and !check(store, high - 1)){
+			// Blocks before low are valid, high is not
+			high--;
+			while (low < high){
+				middle = low + (high - low) / 2;
+				if (check(store, middle)){
+					low = middle + 1;
+				}else{
+					high = middle;
+				}
+			}
+		}
+		next = high;
+		while ((next > 0) and check(store, next - 1) and (((logHeader*)block)->flags & LOG_CONTINUED)){
+			next--;
+		}
+		erase(store, high);
+		used = 0;
+		return next;
+	}
+
+	//! This function will pack a record in the block in RAM. A record that
+	// does not fit writes the block and starts the next one; one longer than
+	// a block fills blocks flagged LOG_CONTINUED, and its end stays in RAM.
+	// If a write fails the records of the block are lost, and a long record
+	// is dropped whole: its first blocks are zeroed and the next one is
+	// written over them
+	int blockLog::append(blockStore &store, const char *data, size_t len)
+	{
+		uint32_t first, last;
+		size_t n;
+
+		if ((used > 0) and (used + len > LOG_PAYLOAD) and !commit(store, 0)){
+			return -1;
+		}
+		first = next;
+		while (len > 0){
+			n = (len < (size_t)(LOG_PAYLOAD - used)) ? len : LOG_PAYLOAD - used;
+			memcpy(block + sizeof(logHeader) + used, data, n);
+			used += n;
+			data += n;
+			len -= n;
+			if ((used == LOG_PAYLOAD) and !commit(store, (len > 0) ? LOG_CONTINUED : 0)){
+				last = next;
+				next = first;
+				erase(store, last);
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	//! This function will write the block in RAM, if it holds any record.
+	// The next records go in a new block, so the rest of this one is unused
+	int blockLog::sync(blockStore &store)
+	{
+		if (used == 0){
+			return 0;
+		}
+		return commit(store, 0) ? 0 : -1;
+	}
+
+	uint16_t blockLog::pending(void)
+	{
+		return used;
+	}
+
+	uint32_t blockLog::getNext(void)
+	{
+		return next;
+	}
+
+	uint16_t blockLog::getReads(void)
+	{
+		return reads;
+	}
+
+	bool blockLog::valid(const uint8_t *block, uint32_t index)
+	{
+		logHeader header;
+		uint32_t crc;
+
+		memcpy(&header, block, sizeof(header));
+		if ((header.magic != LOG_MAGIC) or (header.sequence != index) or (header.length > LOG_PAYLOAD)){
+			return false;
+		}
+		crc = header.crc;
+		header.crc = 0;
+		return logCRC(block + sizeof(header), header.length, logCRC((uint8_t*)&header, sizeof(header))) == crc;
+	}
+
+//***************************************************************
+// Private Methods						*
+//***************************************************************
+
+	bool blockLog::check(blockStore &store, uint32_t index)
+	{
+		reads++;
+		return store.readBlock(index, block) and valid(block, index);
+	}
+
+	//! This function will zero the blocks from next to end, the last first:
+	// if it is cut short, the ones left are still a torn record at the end
+	void blockLog::erase(blockStore &store, uint32_t end)
+	{
+		memset(block, 0, LOG_BLOCK);
+		while ((end > next) and store.writeBlock(end - 1, block)){
+			end--;
+		}
+	}
+
+	bool blockLog::commit(blockStore &store, uint16_t flags)
+	{
+		logHeader *header = (logHeader*)block;
+		bool written;
+
+		header->magic = LOG_MAGIC;
+		header->sequence = next;
+		header->length = used;
+		header->flags = flags;
+		header->crc = 0;
+		memset(block + sizeof(logHeader) + used, 0, LOG_PAYLOAD - used);
+		header->crc = logCRC(block, sizeof(logHeader) + used);
+		written = store.writeBlock(next, block);
+		used = 0;
+		if (written){
+			next++;
+		}
+		return written;
+	}
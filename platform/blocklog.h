@@ -0,0 +1,114 @@
+/*
+ *  Crash-consistent log in blocks
+ *
+ *  The log is a file of LOG_BLOCK byte blocks, each one a sector of
+ *  the card. A block holds a header with a magic number, its index in
+ *  the file as sequence number, the bytes used and a CRC-32, followed
+ *  by the text of the records appended. The records are packed in a
+ *  block in RAM, written when the next record does not fit or when
+ *  sync() is called, and a block is never rewritten: a power loss can
+ *  only tear the block being written and lose the records in RAM, never
+ *  the ones already on the card.
+ *
+ *  A record never straddles two blocks unless it is longer than one:
+ *  then it starts a block and every block but its last is flagged
+ *  LOG_CONTINUED. Blocks flagged at the end of the log are the start of
+ *  a record torn by a power loss.
+ *
+ *  On open, recover() finds where the valid blocks end: it checks the
+ *  last block and, if it is torn, binary searches the first invalid
+ *  one, so it reads O(log n) blocks (23 for 4 GB). It then drops the
+ *  blocks of a torn record and zeroes them, so that none is left valid
+ *  after a block written over them. Appending goes on from there, overwriting
+ *  the torn tail, since the SD library can not truncate a file. Readers
+ *  stop at the first invalid block.
+ *
+ *  The blocks are read and written through blockStore, so the class
+ *  runs on a host over a regular file (tools/dataset).
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef blockLog_h
+#define blockLog_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define	LOG_BLOCK	512		// bytes of a block, a sector of the card
+#define	LOG_MAGIC	0x474F4C45	// "ELOG"
+#define	LOG_PAYLOAD	(LOG_BLOCK - sizeof(logHeader))
+#define	LOG_CONTINUED	0x0001		// flags: the last record goes on in the next block
+
+//! Header at the start of each block
+struct logHeader {
+	uint32_t magic;			// LOG_MAGIC
+	uint32_t sequence;		// index of the block in the file
+	uint16_t length;		// bytes of text after the header
+	uint16_t flags;			// LOG_* flags, 0 in the logs before them
+	uint32_t crc;			// logCRC() of the header, with crc 0, and the text
+} __attribute__((packed));
+
+//! Access to the blocks of a file
+class blockStore {
+	public:
+		virtual ~blockStore(void) {}
+
+		//! Reads a block, false if it is not complete
+		virtual bool readBlock(uint32_t index, uint8_t *block) = 0;
+
+		//! Writes a block and flushes it to the card
+		virtual bool writeBlock(uint32_t index, const uint8_t *block) = 0;
+
+		//! Returns the blocks of the file, the last one may be incomplete
+		virtual uint32_t blocks(void) = 0;
+};
+
+//! CRC-32 (poly 0xEDB88320) of a buffer, continuing a previous one
+uint32_t logCRC(const uint8_t *data, size_t len, uint32_t crc = 0);
+
+class blockLog {
+	uint8_t block[LOG_BLOCK];
+	uint32_t next;			// index of the next block to write
+	uint16_t used;			// bytes of text in the block in RAM
+	uint16_t reads;			// blocks read by the last recover()
+
+	//! Reads a block and tells if it is valid
+	bool check(blockStore &store, uint32_t index);
+
+	//! Zeroes the blocks from next to end, dropped from a torn record
+	void erase(blockStore &store, uint32_t end);
+
+	//! Writes the block in RAM as the next one
+	bool commit(blockStore &store, uint16_t flags);
+	public:
+		blockLog(void);
+
+		//! Returns true if the store is empty or its first block is of a log
+		bool owns(blockStore &store);
+
+		//! Finds the end of the valid records and returns the index of the next block
+		uint32_t recover(blockStore &store);
+
+		//! Appends a record, writing the blocks it fills; returns 0 or -1 if a write failed
+		int append(blockStore &store, const char *data, size_t len);
+
+		//! Writes the records kept in RAM, returns 0 or -1 if the write failed
+		int sync(blockStore &store);
+
+		//! Returns the bytes of the records kept in RAM
+		uint16_t pending(void);
+
+		//! Returns the index of the next block to write
+		uint32_t getNext(void);
+
+		//! Returns the blocks read by the last recover()
+		uint16_t getReads(void);
+
+		//! Returns true if a block is valid at the given index
+		static bool valid(const uint8_t *block, uint32_t index);
+};
+
+#endif
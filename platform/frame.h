@@ -0,0 +1,79 @@
+/*
+ *  Frames sent through LoRa: telemetry of the nodes, and beacons and
+ *  acknowledgements of the gateway. They are told apart by their length.
+ *
+ *  The layout is shared by the platform library (sender) and the
+ *  host tools (gateway ingest), so it only depends on <stdint.h>.
+ *  Multi-byte fields are little endian, as both the SAMD21 and the
+ *  hosts store them.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef frame_h
+#define frame_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define	FRAME_SYNC0	0xA5
+#define	FRAME_SYNC1	0x5A
+#define	FRAME_VERSION	3
+#define	FRAME_FIELDS	10	// floats, in the order of writeSample()
+#define	FRAME_LINK(rate, level)	(((rate) << 4) | (level))	// ADR setting (adr.h)
+
+//! Frame with one sample of a node
+struct TelemetryFrame {
+	uint8_t sync[2];		// FRAME_SYNC0, FRAME_SYNC1
+	uint8_t version;		// FRAME_VERSION
+	uint8_t length;			// sizeof(TelemetryFrame)
+	uint16_t node;			// node identifier
+	uint16_t epoch;			// changes with every reset of the node, never 0
+	uint16_t sequence;		// frame counter of the node, 0 after a reset
+	uint32_t time;			// unix time of the sample (s)
+	uint16_t valid;			// SAMPLE_* flags
+	uint8_t link;			// FRAME_LINK() of the setting it was sent with
+	float fields[FRAME_FIELDS];	// panel, load and battery current and power,
+					// temperature, humidity, battery voltage, wind
+	uint16_t crc;			// frameCRC() of the previous bytes
+} __attribute__((packed));
+
+//! Frame with the network time broadcast by the gateway (TDMA)
+struct BeaconFrame {
+	uint8_t sync[2];		// FRAME_SYNC0, FRAME_SYNC1
+	uint8_t version;		// FRAME_VERSION
+	uint8_t length;			// sizeof(BeaconFrame)
+	uint64_t time;			// ms since the unix epoch when sent
+	uint16_t crc;			// frameCRC() of the previous bytes
+} __attribute__((packed));
+
+//! Acknowledgement of a TelemetryFrame with the setting for the next ones (ADR)
+struct AckFrame {
+	uint8_t sync[2];		// FRAME_SYNC0, FRAME_SYNC1
+	uint8_t version;		// FRAME_VERSION
+	uint8_t length;			// sizeof(AckFrame)
+	uint16_t node;			// node and sequence of the frame acknowledged
+	uint16_t sequence;
+	int16_t rssi;			// dBm of the frame at the gateway
+	int8_t snr;			// dB of the frame at the gateway
+	uint8_t link;			// FRAME_LINK() of the setting for the next frames
+	uint16_t crc;			// frameCRC() of the previous bytes
+} __attribute__((packed));
+
+//! CRC-16/CCITT (poly 0x1021, init 0xFFFF) of a buffer
+static inline uint16_t frameCRC(const uint8_t *data, size_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (len--){
+		crc ^= (uint16_t)(*data++) << 8;
+		for (int i = 0; i < 8; i++){
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+#endif
@@ -1,732 +1,2617 @@
-/*
- *  Function library for the testbed 
- *
- *  Version 1.0
- *  Author: Soledad Escolar
- */
-
-
-// include this library's description file
-
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#include <Adafruit_INA219.h>
-#include <SHT1x.h>
-#include <SPI.h>
-#include <RH_RF95.h>
-#include "platform.h"
-//***************************************************************
-// Variables and definitions					*
-//***************************************************************
-//! Set the version of the class
-	const int vs = 1;
-	
-	#define	ADDRESS0 0x40
-	#define ADDRESS1 0x41
-	#define	ADDRESS2 0x44
-	Adafruit_INA219 ina0(ADDRESS0);
-	Adafruit_INA219 ina1(ADDRESS1);
-	Adafruit_INA219 ina2(ADDRESS2);
-	
-	#define BATTERY  	A0 
-	#define ANENOMETER 	A1
-	#define AUX1 		(3.3/1023)
-	#define AUX2 		(32.4/1.6)
-	#define	WRITE		0
-	#define READ		1
-	
-
-	#define LED           	13
-	#define PINSET		11
-	#define PINUNSET 	12
-	#define CS_SD 		10
-	#define OLED_RESET 	4
-	#define RFM95_CS        8
-	#define RFM95_RST       4
-	#define RFM95_INT       3
-	#define	RFM95_TIMEOUT	1000
-	// Change to 433.0 or other frequency, must match RX's freq!
-	#define RF95_FREQ 	433.0
-
-	
-	#define	SHT1X_ADDRESS	A1
-	#define	SHT1X_CONTROL	A2
-	#define	TEMPERATURE 	"TEMPERATURE\n"
-	#define	HUMIDITY	"HUMIDITY\n"
-	#define	BATTERYVOLT 	"BATTERYVOLT\n"
-	#define DISPLAY_ADDRESS	0x3C	
-	#define WELCOME_MSG	"Starting Platform"	
-	#define VERSION_MSG	(vs)
-	
-	
-	File platformClass::file;
-	bool platformClass::initializedSD=false;
-	bool platformClass::initializedRTC=false;
-	bool platformClass::initializedRFMLoRa=false;
-	
-	// Singleton instance of the rfm95
-	RH_RF95 rf95(RFM95_CS, RFM95_INT);
-
-	// Singleton instance of the rtc
-	RTC_PCF8523 platformClass::rtc;
-	
-	// SHT1x sensor
-	SHT1x sht1x(SHT1X_ADDRESS,SHT1X_CONTROL);
-	
-	// display
-	Adafruit_SSD1306 display(OLED_RESET);
-	
-//***************************************************************
-// Constructor of the class					*
-//***************************************************************
-
-	//! Function that handles the creation and setup of instances
-	platformClass::platformClass(void) { 
-		
-		pinMode(LED,OUTPUT);
-		pinMode(CS_SD, OUTPUT);
-		pinMode(RFM95_CS, OUTPUT);
-		pinMode(PINSET, OUTPUT);
-		pinMode(PINUNSET, OUTPUT);
-		digitalWrite(PINSET, LOW);
-		digitalWrite(PINUNSET, LOW);
-		digitalWrite(LED,HIGH);	
-	}
-	
-	
-//***************************************************************
-// Public Methods						*
-//***************************************************************
-
-	//!******************************************************************************
-	//!		Name:	initIoTNode()						*
-	//!		Description: initializes the pins for IoT node			*
-	//!		Param : void							*
-	//!		Returns: void							*
-	//!		Example: platform.initIoTnode();				*
-	//!******************************************************************************
-
-	void platformClass::initIoTNode(void)
-	{
-		pinMode(LED,OUTPUT);
-		pinMode(BATTERY, INPUT);
-		digitalWrite(LED,HIGH);
-	}
-
-	
-	//!******************************************************************************
-	//!		Name:	version()						*
-	//!		Description: It check the version of the library		*
-	//!		Param : void							*
-	//!		Returns: void							*
-	//!		Example: platform.version();					*
-	//!******************************************************************************
-
-	int platformClass::version(void)
-	{
-		return vs;
-	}
-
-	//!******************************************************************************
-	//!	Name:	initializeRTC()							*
-	//!	Description: Initializes the Real Time Clock (RTC)			*
-	//!	Param : void								*
-	//!	Returns: int with the success (0) or fail (-1) of the initialization	*													
-	//!	Example: platform.initializeRTC();					*
-	//!******************************************************************************
-
-	int platformClass::initializeRTC(void)
-	{
-		if (! platformClass::rtc.begin()) {
-			Serial.println("DEBUG: RTC not found!");
-			return -1;
-		}
-		platformClass::initializedRTC = true;
-		return int(platformClass::initializedRTC);
-	}
-
-	//!******************************************************************************
-	//!	Name:	adjustRTC()							*
-	//!	Description: Set the RTC to the date & time this sketch was compiled	*
-	//!	Param : void								*
-	//!	Returns: void								*
-	//!	Example: platform.adjustRTC();						*
-	//!******************************************************************************
-	void platformClass::adjustRTC(void)
-	{
-		if (! platformClass::rtc.initialized()) {
-			Serial.println("DEBUG: RTC is NOT running!");
-			platformClass::rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
-		}else{
-			Serial.println("DEBUG: RTC initialized!");
-		}
-	}
-
-	//!******************************************************************************
-	//!	Name:	initializeLoRa()						*
-	//!	Description: Initializes the LORA communication module.			*
-	//!	Param : void								*
-	//!	Returns: int with the success (0) or fail (-1) of the initialization	*
-	//!	Example: platform.initializeLoRa();					*
-	//!******************************************************************************
-	int platformClass::initializeLoRa(void)
-	{
-		digitalWrite(CS_SD, HIGH);	   //Disable SD
-		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
-		while (!rf95.init()) {
-			Serial.println("DEBUG: RFM LoRa not initialized!");
-			while (1);
-		}
-		platformClass::initializedRFMLoRa = true;
-		Serial.println("DEBUG: RFM LoRa initialized!");
-
-		// Defaults after init are 434.0MHz, modulation GFSK_Rb250Fd250, +13dbM
-	  	if (!rf95.setFrequency(RF95_FREQ)) {
-			Serial.println("DEBUG: Setting LoRa frequency failed!");
-    			while (1);
-  		}
-		Serial.println("DEBUG: Setting LoRa frequency !");
-
-  		// Defaults after init are 434.0MHz, 13dBm, Bw = 125 kHz, Cr = 4/5, Sf = 128chips/symbol, CRC on
-  		// you can set transmitter powers from 5 to 23 dBm:
-		rf95.setTxPower(23, false);
-		return int(platformClass::initializedRFMLoRa);
-	}
-	
-	//!******************************************************************************
-	//!	Name:	sendLoRa()							*
-	//!	Description: send data through the LORA communication module.		*
-	//!	Param : data to send							*
-	//!	Returns: int with the success (0) or fail (-1) of the initialization	*
-	//!	Example: platform.sendLoRa();						*
-	//!******************************************************************************
-	int platformClass::sendLoRa(String data)
-	{
-		const char *msg=data.c_str();
-
-		digitalWrite(CS_SD, HIGH);	   //Disable SD
-		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
-
-		Serial.print("DEBUG: Sending Message: ");
-		Serial.println(msg);
-		rf95.send((uint8_t*)msg, sizeof(msg));
-	 	delay(10);
-		rf95.waitPacketSent();
-		return 0;
-	}
-	
-	//!******************************************************************************
-	//!	Name:	receiveLoRa()							*
-	//!	Description: receive data through the LORA communication module.	*
-	//!	Param : void								*
-	//!	Returns: String with the data received					*
-	//!	Example: platform.receiveLoRa();					*
-	//!******************************************************************************
-	String platformClass::receiveLoRa(void)
-	{
-		uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
-  		uint8_t len = sizeof(buf);
- 
-		digitalWrite(CS_SD, HIGH);	   //Disable SD
-		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
-    		// Should be a reply message for us now   
-		if (rf95.waitAvailableTimeout(RF95_FREQ)) 
-		{	
-			if (rf95.recv(buf, &len))
-   			{
-      				Serial.print("DEBUG: received from LoRA : ");
-				Serial.println((char*)buf);
-			      	//Serial.print("RSSI: ");
-			      	//Serial.println(rf95.lastRssi(), DEC);    
-			}else{
-				Serial.println("DEBUG: recv failed!");
-			}
-		}else{
-			Serial.println("DEBUG: No reply recv from LoRa module!");
-		}
-		return (char*)buf;
-	}
-		
-	//!******************************************************************************
-	//!	Name:	getTemperature()						*
-	//!	Description: Read the temperature sensor				*
-	//!	Param : void								*
-	//!	Returns: float with the temperature					*
-	//!	Example: platform.getTemperature();					*
-	//!******************************************************************************
-	float platformClass::getTemperature(void)
-	{
-		
-		char inChar;
-		String temp="";
-		Serial1.print(TEMPERATURE);
-		bool end=false;
-		while (!end){
-			while (Serial1.available()) {
-				inChar = (char)Serial1.read();
-				temp += inChar;
-				if (inChar == '\n') {
-					end = true;
-					break;
-				}
-				
-			}
-			if (end) {break;}
-		}
-		const char* foo = temp.c_str();
-		return (atof(foo));
-	}
- 	
-	//!******************************************************************************
-	//!	Name:	getHumidity()							*
-	//!	Description: Read the humidity						*
-	//!	Param : void								*
-	//!	Returns: float with the humidity					*
-	//!	Example: platform.getHumidity();					*
-	//!******************************************************************************
-	float platformClass::getHumidity(void)
-	{
-
-		char inChar;
-		String hum="";
-		Serial1.print(HUMIDITY);
-		bool end=false;
-		while (!end){
-			while (Serial1.available()) {
-				inChar = (char)Serial1.read();
-				hum += inChar;
-				if (inChar == '\n') {
-					end = true;
-					break;
-				}
-				
-			}
-			if (end) {break;}
-		}
-		const char* foo = hum.c_str();
-		return (atof(foo));
-	}
-	//!******************************************************************************
-	//!	Name:	getBatteryVoltage()						*
-	//!	Description: Read the battery voltage					*
-	//!	Param : void								*
-	//!	Returns: float with the battery voltage					*
-	//!	Example: platform.getBatteryVoltage();					*
-	//!******************************************************************************
-	float platformClass::getBatteryVoltage(void)
-	{
-		char inChar;
-		String batt="";
-		Serial1.print(BATTERYVOLT);
-		bool end=false;
-		while (!end){
-			while (Serial1.available()) {
-				inChar = (char)Serial1.read();
-				batt += inChar;
-				if (inChar == '\n') {
-					end = true;
-					break;
-				}
-				
-			}
-			if (end) {break;}
-		}
-		const char* foo = batt.c_str();
-		return (atof(foo));
-	}
-	//!******************************************************************************
-	//!	Name:	getTime()							*
-	//!	Description: get the time in which a sample is collected		*
-	//!	Param : void								*
-	//!	Returns: String								*
-	//!	Example: platform.getTime();						*
-	//!******************************************************************************
-	String  platformClass::getTime()
-	{
-		char date[20];
-		
-		if (!platformClass::initializedRTC){
-			return "";
-		}
-		DateTime now = platformClass::rtc.now(); //Obtener fecha y hora actual.
-
-		int day = now.day();
-		int month = now.month();
-		int year = now.year();
-		int hour = now.hour();
-		int minute = now.minute();
-		int second = now.second();
-
-		sprintf( date, "%.2d.%.2d.%.4d %.2d:%.2d:%.2d", day, month, year, hour, minute, second); 
-		return String( date );
-	}  
-	
-	//!******************************************************************************
-	//!	Name:	initINA0()							*
-	//!	Description: Initializes sensor INA0					*
-	//!	Param : void								*
-	//!	Returns: void								*
-	//!	Example: platform.initINA0();						*
-	//!******************************************************************************
-	void platformClass::initINA0(void)
-	{
-		ina0.begin();
-	}
-
-
-	//!******************************************************************************
-	//!	Name:	getPanelCurrent()						*
-	//!	Description: Read the current sensor INA0				*
-	//!	Param : void								*
-	//!	Returns: float with the current of the panel				*
-	//!	Example: platform.getPanelCurrent();					*
-	//!******************************************************************************
-	float platformClass::getPanelCurrent(void)
-	{
-		float current=0.0;
-		ina0.begin();
-	
-		relay(PINSET);
-		delay(1000);   
-		current = ina0.getCurrent_mA();
-		relay(PINUNSET);  
-		return current;
-	}
-	
-	
-	//!******************************************************************************
-	//!	Name:	initINA1()							*
-	//!	Description: Initializes sensor INA1					*
-	//!	Param : void								*
-	//!	Returns: void								*
-	//!	Example: platform.initINA1();						*
-	//!******************************************************************************
-	void platformClass::initINA1(void)
-	{
-		ina1.begin();
-	}
-	//!******************************************************************************
-	//!	Name:	getLoadCurrent()						*
-	//!	Description: Read the current sensor INA1				*
-	//!	Param : void								*
-	//!	Returns: float with the load current 					*
-	//!	Example: platform.getLoadCurrent();					*
-	//!******************************************************************************
-	float platformClass::getLoadCurrent(void)
-	{
-		float current=0.0;
-		ina1.begin();
-		current = ina1.getCurrent_mA();
-		return current;
-	}
-	
-	//!******************************************************************************
-	//!	Name:	initINA2()							*
-	//!	Description: Initializes sensor INA2					*
-	//!	Param : void								*
-	//!	Returns: void								*
-	//!	Example: platform.initINA2();						*
-	//!******************************************************************************
-	void platformClass::initINA2(void)
-	{
-		ina2.begin();
-	}
-	//!******************************************************************************
-	//!	Name:	getBatteryCurrent()						*
-	//!	Description: Read the current sensor INA2				*
-	//!	Param : void								*
-	//!	Returns: float with the current of the battery				*
-	//!	Example: platform.getBatteryCurrent();					*
-	//!******************************************************************************
-	float platformClass::getBatteryCurrent(void)
-	{
-		float current=0.0;
-		ina2.begin();
-		current = ina2.getCurrent_mA();
-		return current;
-	}	
-
-
-
-	//!******************************************************************************
-	//!	Name:	getPanelPower()							*
-	//!	Description: Read the power from sensor INA0				*
-	//!	Param : void								*
-	//!	Returns: float with the power of the panel				*
-	//!	Example: platform.getPanelPower();					*
-	//!******************************************************************************
-	float platformClass::getPanelPower(void)
-	{
-		float power=0.0;
-		relay(PINSET);
-		delay(1000);   
-		power = ina0.getPower_mW();
-		relay(PINUNSET);  
-		return power;
-	}
-	
-	
-	//!******************************************************************************
-	//!	Name:	getLoadPower()							*
-	//!	Description: Read the power from sensor INA1				*
-	//!	Param : void								*
-	//!	Returns: float with the load power 					*
-	//!	Example: platform.getLoadPower();					*
-	//!******************************************************************************
-	float platformClass::getLoadPower(void)
-	{
-		float power=0.0;
-
-		power = ina1.getPower_mW();
-		return power;
-	}
-	
-	//!******************************************************************************
-	//!	Name:	getBatteryPower()						*
-	//!	Description: Read the power from sensor INA2				*
-	//!	Param : void								*
-	//!	Returns: float with the power of the battery				*
-	//!	Example: platform.getBatteryPower();					*
-	//!******************************************************************************
-	float platformClass::getBatteryPower(void)
-	{
-		float power=0.0;
-
-		power = ina2.getPower_mW();
-		return power;
-	}	
-	
-
-	
-	//!******************************************************************************
-	//!	Name:	getSpeedOfWind()						*
-	//!	Description: Returns the speed of the wind (ANENOMETER)			*
-	//!	Param : void								*
-	//!	Returns: float with the ANENOMETER value in meters per second		*
-	//!	Example: platform.getSpeedOfWind();					*
-	//!******************************************************************************
-	float  platformClass::getSpeedOfWind(void)
-	{
-		float windOfSpeed = 0.0;
-		
-		//Reading from ANENOMETER and conversion to meters/second according to the datasheet 
-		windOfSpeed = ((AUX1*analogRead(ANENOMETER))-0.4)*AUX2;
-		return windOfSpeed;
-	}
-	
-
-	//!******************************************************************************
-	//!	Name:	open()								*
-	//!	Description: open a file on the memory card				*
-	//!	Param : filename, mode							*
-	//!	Returns: int 0 if ok and -1 if not ok					*
-	//!	Example: platform.open();						*
-	//!******************************************************************************
-	int  platformClass::open(String filename, int mode)
-	{
-		
-		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
-		digitalWrite(CS_SD, LOW);	   //Enable SD
-		if (platformClass::initializedSD){
-			if (mode == WRITE){
-				platformClass::file = SD.open(filename,FILE_WRITE);
-				if (!platformClass::file){
-					Serial.println("DEBUG1: Open file failed!");
-					return -1;
-				}
-			}else{
-				platformClass::file = SD.open(filename);
-				if (!platformClass::file){
-					Serial.println("DEBUG: Open file failed!");
-					return -1;
-				}
-			}
-			return 0;
-		}else{
-			Serial.println("DEBUG: Open file failed!");
-		}
-		return -1;
-		
-	
-	}
-	
-	
-	//!******************************************************************************
-	//!	Name:	close()								*
-	//!	Description: close a file 						*
-	//!	Param : void								*
-	//!	Returns: void								*
-	//!	Example: platform.close();						*
-	//!******************************************************************************
-	void  platformClass::close()
-	{
-		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
-		digitalWrite(CS_SD, LOW);	   //Enable SD
-		if (platformClass::file){
-			platformClass::file.close();
-		}
-	}  
-	
-	//!******************************************************************************
-	//!	Name:	write()								*
-	//!	Description: write data into memory card SD				*
-	//!	Param : String to write							*
-	//!	Param : File to write							*
-	//!	Returns: 0 if success or -1 if fail					*
-	//!	Example: platform.writeln();						*
-	//!******************************************************************************
-	int  platformClass::writeline(String data)
-	{
-		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
-		digitalWrite(CS_SD, LOW);	   //Enable SD
-		if (platformClass::file){
-			file.println(data); 	
-			return 0;
-		}
-		return -1;
-		
-	}
-	
-	//!******************************************************************************
-	//!	Name:	readline()							*
-	//!	Description: read data from memory card SD				*
-	//!	Param : File to read							*
-	//!	Returns: String with the data 						*
-	//!	Example: platform.readline();						*
-	//!******************************************************************************
-	String  platformClass::readline()
-	{
-		String data="";
-		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
-		digitalWrite(CS_SD, LOW);	   //Enable SD
-		if ((platformClass::file) and (platformClass::file.available())){
-			data = file.read();
-		}
-		return data;
-	}
-	
-
-	//!******************************************************************************
-	//!	Name:	initializeDisplay()						*
-	//!	Description: Initialize the LCD						*
-	//!	Param : void								*
-	//!	Returns: void								*
-	//!	Example: platform.initializeDisplay();					*
-	//!******************************************************************************
-	void  platformClass::initializeDisplay(void)
-	{
-		display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS);
-   
-		delay(2000);
-		clean();
-		display.println(WELCOME_MSG);
-		display.println(VERSION_MSG);
-		display.display();
-		
-		Serial.println("DEBUG: Display Initialized!");
-	}
-	
-	//!******************************************************************************
-	//!	Name:	displayLCD()							*
-	//!	Description: Display data on screen					*
-	//!	Param : String with the title and 					*
-	//!	Param : String with the data 						*
-	//!	Returns: void								*
-	//!	Example: platform.displayLCD();						*
-	//!******************************************************************************
-	void  platformClass::displayLCD(String title, String data)
-	{	
-		clean();
-		
-		display.print(title);
-		display.print(':');
-		display.print(data);
-		display.display();
-	}
-
-	//! This function will read the temperature sensor of IoTnode 
-	float platformClass::readTemperature(){
-		float value;
-		value = sht1x.readTemperatureC();
-		if (isnan(value)) {  // check if 'is not a number'
-			return -1000.0;
-		} 
-		return value;
-	}
-	//! This function will read the humidity sensor of IoTnode 
-	float platformClass::readHumidity(){	
-		float value;
-		value = sht1x.readHumidity();
-		if (isnan(value)) {  // check if 'is not a number'
-			return -1.0;
-		} else { 
-    		return value;
-		}
-	}
-	//! This function will read the battery voltage of IoTnode 
-	
-	float platformClass::readBatteryVoltage(){	
-		float value;
-		value = analogRead(BATTERY) * AUX1;
-		return value;
-	}
-	
-//***************************************************************
-// Private Methods						*
-//***************************************************************
-
-		
-	//! This function will change the status of the relay:  
-	// Short circuit current of the panel: we close relay and wait 
-	//current be stablished again, then it puts the relay in its original state
-
-	void platformClass::relay(int status)
-	{
-		digitalWrite(status,HIGH);
-		delay(10);
-		digitalWrite(status,LOW);
-	}
-	
-	//! This function will prepare the display for visualization
-	void platformClass::clean(void)
-	{
-		display.clearDisplay();
-		display.setTextSize(1);
-		display.setTextColor(WHITE);
-		display.setCursor(0,0);
-	}
-	
-	//!******************************************************************************
-	//!	Name:	initializeSD()							*
-	//!	Description: Initialize the memory card SD				*
-	//!	Param : void								*
-	//!	Returns: int with the success (0) or fail (-1) of the initialization 	*
-	//!	Example: platform.initializeSD();					*
-	//!******************************************************************************
-	int  platformClass::initializeSD(void)
-	{
-		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
-		digitalWrite(CS_SD, LOW);	   //Enable SD
-		if (!SD.begin(CS_SD)){
-			Serial.println("DEBUG: SD initialization failed!");
-			platformClass::initializedSD = false;
-			return -1;
-		}
-		platformClass::initializedSD = true;
-		Serial.println("DEBUG: SD Initialized!");
-		return 0;
-	}
-
-	
-	
-//***************************************************************
-// Preinstantiate Objects					*
-//***************************************************************
-
-	platformClass platform = platformClass();
-
-
-
-
-
+/*
+ *  Function library for the testbed 
+ *
+ *  Version 1.0
+ *  Author: Soledad Escolar
+ */
+
+
+// include this library's description file
+
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <Adafruit_INA219.h>
+#include <SPI.h>
+#include <RH_RF95.h>
+#include "platform.h"
+#include "wind.h"
+#include "tdma.h"
+#include "airtime.h"
+#include "blocklog.h"
+//***************************************************************
+// Variables and definitions					*
+//***************************************************************
+//! Set the version of the class
+	const int vs = 1;
+	
+	#define	ADDRESS0 0x40
+	#define ADDRESS1 0x41
+	#define	ADDRESS2 0x44
+	Adafruit_INA219 ina0(ADDRESS0);
+	Adafruit_INA219 ina1(ADDRESS1);
+	Adafruit_INA219 ina2(ADDRESS2);
+	
+	#define BATTERY  	A0 
+	#define ANENOMETER 	A1
+	#define AUX1 		(3.3/1023)
+	#define AUX2 		(32.4/1.6)
+	#define	WIND_SPEED(x)	(((AUX1*(x))-0.4)*AUX2)	// anenometer reading to m/s
+	#define	WIND_RATE	10	// Hz of the background capture
+	#define	WIND_GUST	3	// s of the mean of a gust
+	#define	ACQUIRE_TICK	10	// ms between checks of timer TC4 for a snapshot
+	#define	ACQUIRE_PRIORITY	3	// lowest, the radio and the serial ports go first
+	#define	WRITE		0
+	#define READ		1
+	#define	LOG_ROLLOVER	99	// names tried after a file that is not a log: DATA1.LOG to DATA99.LOG
+	
+
+	#define LED           	13
+	#define PINSET		11
+	#define PINUNSET 	12
+	#define CS_SD 		10
+	#define OLED_RESET 	4
+	#define RFM95_CS        8
+	#define RFM95_RST       4
+	#define RFM95_INT       3
+	#define	RFM95_TIMEOUT	1000
+	#define	RFM95_RETRY	10	// ms between initialization attempts
+	#define	PANEL_SETTLE	1000	// ms the panel needs after switching the relay
+	#define	SERIAL1_TIMEOUT	1000	// ms to wait for an answer on Serial1
+	#define	ADR_NODES	16	// nodes (slots with TDMA) adapted by the gateway
+	#define	ADR_TURNAROUND	100	// ms the gateway takes to acknowledge a frame
+	// Change to 433.0 or other frequency, must match RX's freq!
+	#define RF95_FREQ 	433.0
+
+	
+	#define	SHT1X_ADDRESS	A1	// data
+	#define	SHT1X_CONTROL	A2	// clock
+	#define	SHT1X_TEMPERATURE	0x03	// measure temperature command
+	#define	SHT1X_HUMIDITY		0x05	// measure humidity command
+	#define	SHT1X_IDLE	0	// climateState: no measurement
+	#define	SHT1X_TIMEOUT	400	// ms, 14 bit conversion takes up to 320
+	#define	SHT1X_D1	(-40.0)	// temperature coefficients
+	#define	SHT1X_D2	0.01
+	#define	SHT1X_C1	(-4.0)	// humidity coefficients
+	#define	SHT1X_C2	0.0405
+	#define	SHT1X_C3	(-0.0000028)
+	#define	SHT1X_T1	0.01	// humidity temperature compensation
+	#define	SHT1X_T2	0.00008
+	#define	TEMPERATURE 	"TEMPERATURE\n"
+	#define	HUMIDITY	"HUMIDITY\n"
+	#define	BATTERYVOLT 	"BATTERYVOLT\n"
+	#define DISPLAY_ADDRESS	0x3C	
+	#define WELCOME_MSG	"Starting Platform"	
+	#define VERSION_MSG	(vs)
+	
+	
+	File platformClass::file;
+	bool platformClass::logging=false;
+	uint8_t platformClass::initialized=0;
+	uint8_t platformClass::failed=0;
+	BootTime platformClass::boot;
+	uint16_t platformClass::nodeId=0;
+	uint16_t platformClass::epoch=0;
+	uint16_t platformClass::sequence=0;
+	bool platformClass::capturingWind=false;
+	bool platformClass::acquiring=false;
+	bool platformClass::tdmaEnabled=false;
+	bool platformClass::adrEnabled=false;
+	uint8_t platformClass::radioRate=ADR_DEFAULT;
+	uint8_t platformClass::radioLevel=0;
+	uint16_t platformClass::adrSlot=0;
+	bool platformClass::adrHeard=false;
+	uint8_t platformClass::climateState=SHT1X_IDLE;
+	unsigned long platformClass::climateStarted=0;
+	float platformClass::climateTemperature=0.0;
+	
+	// Singleton instance of the rfm95
+	RH_RF95 rf95(RFM95_CS, RFM95_INT);
+
+	// Singleton instance of the rtc
+	RTC_PCF8523 platformClass::rtc;
+	
+	// display
+	Adafruit_SSD1306 display(OLED_RESET);
+
+	// Time slots of the uplink
+	tdmaScheduler tdma;
+
+	// Setting of the node and frames sent with each one; settings of the nodes at the gateway
+	adrController adr;
+	adrStats adrTotals;
+	adrController adrNodes[ADR_NODES];
+
+	// Blocks of the log on the SD (blocklog.h)
+	class sdBlocks : public blockStore {
+		File &file;
+		public:
+			sdBlocks(File &f) : file(f) {}
+
+			bool readBlock(uint32_t index, uint8_t *block)
+			{
+				return file.seek(index * LOG_BLOCK) and (file.read(block, LOG_BLOCK) == LOG_BLOCK);
+			}
+
+			bool writeBlock(uint32_t index, const uint8_t *block)
+			{
+				if (!file.seek(index * LOG_BLOCK) or (file.write(block, LOG_BLOCK) != LOG_BLOCK)){
+					return false;
+				}
+				file.flush();
+				return true;
+			}
+
+			uint32_t blocks(void)
+			{
+				return (file.size() + LOG_BLOCK - 1) / LOG_BLOCK;
+			}
+	};
+	blockLog sdLog;
+
+	// Trace recorded on the SD (trace.h): records are packed in RAM and a
+	// block is appended when the next record does not fit. During sample()
+	// a full block waits in RAM, so the SD write does not lengthen the cycle
+	class sdTrace : public traceBackend {
+		traceWriter block;
+		uint8_t full[LOG_PAYLOAD];	// block waiting for the end of the sample
+		uint16_t fullSize;
+		bool deferring;
+		blockLog log;
+
+		//! Appends a block to the trace on the SD and syncs it
+		int write(const uint8_t *data, uint16_t size)
+		{
+			sdBlocks store(file);
+			int result;
+
+			digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+			digitalWrite(CS_SD, LOW);	   //Enable SD
+			result = log.append(store, (const char*)data, size);
+			if (result == 0){
+				result = log.sync(store);
+			}
+			return result;
+		}
+
+		//! Writes the block waiting in RAM, if any
+		int waiting(void)
+		{
+			int result = 0;
+
+			if (fullSize > 0){
+				result = write(full, fullSize);
+				fullSize = 0;
+			}
+			return result;
+		}
+
+		//! The block is full: writes it, or keeps it in RAM while deferring
+		void next(void)
+		{
+			if (deferring and (fullSize == 0)){
+				memcpy(full, block.data(), block.size());
+				fullSize = block.size();
+				block.clear();
+			}else{
+				flush();
+			}
+		}
+		public:
+			File file;
+
+			sdTrace(void) : fullSize(0), deferring(false)
+			{
+			}
+
+			//! Resumes the trace after its last valid block, -1 if the file is not a trace
+			int recover(void)
+			{
+				sdBlocks store(file);
+
+				if (!log.owns(store)){
+					return -1;
+				}
+				log.recover(store);
+				return 0;
+			}
+
+			int flush(void)
+			{
+				int result = waiting();
+
+				// A block that cannot be written is dropped, not kept full
+				if ((block.size() > 0) and (write(block.data(), block.size()) != 0)){
+					result = -1;
+				}
+				block.clear();
+				return result;
+			}
+
+			//! Full blocks wait in RAM until resume()
+			void defer(void)
+			{
+				deferring = true;
+			}
+
+			//! Writes the block that waited, if any, and stops deferring
+			int resume(void)
+			{
+				deferring = false;
+				return waiting();
+			}
+
+			void start(uint32_t unixtime)
+			{
+				uint32_t now = millis();
+
+				if (!block.start(now, unixtime)){
+					next();
+					block.start(now, unixtime);
+				}
+			}
+
+			float reading(uint8_t kind, float value)
+			{
+				uint32_t now = millis();
+
+				if (!block.reading(kind, now, value)){
+					next();
+					block.reading(kind, now, value);
+				}
+				return value;
+			}
+
+			void event(uint8_t kind, uint32_t time, const void *data, uint8_t length)
+			{
+				if (!block.event(kind, time, data, length)){
+					next();
+					block.event(kind, time, data, length);
+				}
+			}
+	};
+	sdTrace recorder;
+	traceBackend *tracer = NULL;
+
+	// Readings of the anenometer taken by the timer
+	windCapture anenometer(WIND_RATE*WIND_GUST);
+
+	// Packet that fell out of the TDMA slot: the next call in the slot sends it
+	#define	PENDING_NONE	0
+	#define	PENDING_TEXT	1	// sendLoRa()
+	#define	PENDING_SAMPLE	2	// sendSample()
+	uint8_t pendingKind = PENDING_NONE;
+	String pendingText;
+	Sample pendingSample;
+
+	// Snapshots of the fast channels taken by timer TC4 (sampleQueue.h)
+	sampleQueue snapshots;
+	volatile uint16_t acquirePeriod = 0;	// ms between snapshots
+	volatile uint16_t acquireSources = 0;	// SAMPLE_* flags of the channels
+	volatile uint32_t acquireLast = 0;	// millis() of the last snapshot
+	volatile uint32_t acquireTaken = 0;	// snapshots taken
+	
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	//! Function that handles the creation and setup of instances
+	platformClass::platformClass(void) { 
+		
+		pinMode(LED,OUTPUT);
+		pinMode(CS_SD, OUTPUT);
+		pinMode(RFM95_CS, OUTPUT);
+		pinMode(PINSET, OUTPUT);
+		pinMode(PINUNSET, OUTPUT);
+		digitalWrite(PINSET, LOW);
+		digitalWrite(PINUNSET, LOW);
+		digitalWrite(LED,HIGH);	
+	}
+	
+	
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	initIoTNode()						*
+	//!		Description: initializes the pins for IoT node			*
+	//!		Param : void							*
+	//!		Returns: void							*
+	//!		Example: platform.initIoTnode();				*
+	//!******************************************************************************
+
+	void platformClass::initIoTNode(void)
+	{
+		pinMode(LED,OUTPUT);
+		pinMode(BATTERY, INPUT);
+		digitalWrite(LED,HIGH);
+	}
+
+	
+	//!******************************************************************************
+	//!		Name:	version()						*
+	//!		Description: It check the version of the library		*
+	//!		Param : void							*
+	//!		Returns: void							*
+	//!		Example: platform.version();					*
+	//!******************************************************************************
+
+	int platformClass::version(void)
+	{
+		return vs;
+	}
+
+	//!******************************************************************************
+	//!	Name:	initialize()							*
+	//!	Description: Initializes the given peripherals. The others are		*
+	//!	initialized the first time they are used, so the first sample is not	*
+	//!	delayed by peripherals it does not need. A peripheral that fails is	*
+	//!	not tried again (degraded mode) unless it is passed here again.		*
+	//!	Param : PERIPHERAL_* flags						*
+	//!	Returns: int with the success (0) or fail (-1) of any initialization	*
+	//!	Example: platform.initialize(PERIPHERAL_SD|PERIPHERAL_RTC);		*
+	//!******************************************************************************
+	int platformClass::initialize(uint8_t peripherals)
+	{
+		int status = 0;
+
+		platformClass::failed &= ~peripherals;
+		for (uint8_t p = 1; p & PERIPHERAL_ALL; p <<= 1){
+			if ((peripherals & p) and !ensure(p)){
+				status = -1;
+			}
+		}
+		platformClass::boot.ready = millis();
+		return status;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getDegraded()							*
+	//!	Description: Returns the peripherals that failed to initialize		*
+	//!	Param : void								*
+	//!	Returns: uint8_t with the PERIPHERAL_* flags				*
+	//!	Example: if (platform.getDegraded() & PERIPHERAL_LORA) {...}		*
+	//!******************************************************************************
+	uint8_t platformClass::getDegraded(void)
+	{
+		return platformClass::failed;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getBootTime()							*
+	//!	Description: Returns the time spent initializing each peripheral and	*
+	//!	the time since reset until initialize() and the first sample ended	*
+	//!	Param : void								*
+	//!	Returns: BootTime							*
+	//!	Example: platform.getBootTime().firstSample;				*
+	//!******************************************************************************
+	BootTime platformClass::getBootTime(void)
+	{
+		return platformClass::boot;
+	}
+
+	//!******************************************************************************
+	//!	Name:	initializeRTC()							*
+	//!	Description: Initializes the Real Time Clock (RTC)			*
+	//!	Param : void								*
+	//!	Returns: int with the success (0) or fail (-1) of the initialization	*													
+	//!	Example: platform.initializeRTC();					*
+	//!******************************************************************************
+
+	int platformClass::initializeRTC(void)
+	{
+		bool started;
+
+		holdAcquisition();
+		started = platformClass::rtc.begin();
+		releaseAcquisition();
+		if (!started) {
+			Serial.println("DEBUG: RTC not found!");
+			platformClass::failed |= PERIPHERAL_RTC;
+			return -1;
+		}
+		platformClass::initialized |= PERIPHERAL_RTC;
+		return 0;
+	}
+
+	//!******************************************************************************
+	//!	Name:	adjustRTC()							*
+	//!	Description: Set the RTC to the date & time this sketch was compiled	*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.adjustRTC();						*
+	//!******************************************************************************
+	void platformClass::adjustRTC(void)
+	{
+		bool running;
+
+		holdAcquisition();
+		running = platformClass::rtc.initialized();
+		if (!running) {
+			platformClass::rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+		}
+		releaseAcquisition();
+		if (!running) {
+			Serial.println("DEBUG: RTC is NOT running!");
+		}else{
+			Serial.println("DEBUG: RTC initialized!");
+		}
+	}
+
+	//!******************************************************************************
+	//!	Name:	initializeLoRa()						*
+	//!	Description: Initializes the LORA communication module.			*
+	//!	Param : void								*
+	//!	Returns: int with the success (0) or fail (-1) of the initialization	*
+	//!	Example: platform.initializeLoRa();					*
+	//!******************************************************************************
+	int platformClass::initializeLoRa(void)
+	{
+		unsigned long start = millis();
+
+		digitalWrite(CS_SD, HIGH);	   //Disable SD
+		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
+		while (!rf95.init()) {
+			if (millis() - start >= RFM95_TIMEOUT){
+				Serial.println("DEBUG: RFM LoRa not initialized!");
+				platformClass::failed |= PERIPHERAL_LORA;
+				return -1;
+			}
+			delay(RFM95_RETRY);
+		}
+		Serial.println("DEBUG: RFM LoRa initialized!");
+
+		// Defaults after init are 434.0MHz, modulation GFSK_Rb250Fd250, +13dbM
+	  	if (!rf95.setFrequency(RF95_FREQ)) {
+			Serial.println("DEBUG: Setting LoRa frequency failed!");
+			platformClass::failed |= PERIPHERAL_LORA;
+			return -1;
+  		}
+		Serial.println("DEBUG: Setting LoRa frequency !");
+
+  		// Defaults after init are 434.0MHz, 13dBm, Bw = 125 kHz, Cr = 4/5, Sf = 128chips/symbol, CRC on
+  		// you can set transmitter powers from 5 to 23 dBm:
+		rf95.setTxPower(adrPower(0), false);
+		platformClass::radioRate = ADR_DEFAULT;
+		platformClass::radioLevel = 0;
+		platformClass::initialized |= PERIPHERAL_LORA;
+		return 0;
+	}
+	
+	//!******************************************************************************
+	//!	Name:	sendLoRa()							*
+	//!	Description: send data through the LORA communication module.		*
+	//!	With TDMA, out of the slot of the node the data is kept and it	*
+	//!	returns LORA_WAIT: the next call of sendLoRa(), sendSample(),		*
+	//!	sendPending() or drainSamples() in the slot sends it. Only the last	*
+	//!	packet out of the slot is kept.					*
+	//!	Param : data to send							*
+	//!	Returns: int with the success (0), LORA_WAIT or fail (-1)		*
+	//!	Example: platform.sendLoRa();						*
+	//!******************************************************************************
+	int platformClass::sendLoRa(String data)
+	{
+		int result;
+
+		if (!ensure(PERIPHERAL_LORA)){
+			return -1;
+		}
+		// The packet kept before goes first, if the slot is on
+		result = (sendPending() == LORA_WAIT) ? LORA_WAIT : transmitText(data);
+		if (result == LORA_WAIT){
+			keepPending();
+			pendingKind = PENDING_TEXT;
+			pendingText = data;
+		}
+		return result;
+	}
+	
+	//!******************************************************************************
+	//!	Name:	receiveLoRa()							*
+	//!	Description: receive data through the LORA communication module.	*
+	//!	Param : void								*
+	//!	Returns: String with the data received					*
+	//!	Example: platform.receiveLoRa();					*
+	//!******************************************************************************
+	String platformClass::receiveLoRa(void)
+	{
+		uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
+  		uint8_t len = sizeof(buf);
+ 
+		if (!ensure(PERIPHERAL_LORA)){
+			return "";
+		}
+		tune(ADR_DEFAULT, platformClass::radioLevel);
+		digitalWrite(CS_SD, HIGH);	   //Disable SD
+		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
+    		// Should be a reply message for us now   
+		if (rf95.waitAvailableTimeout(RF95_FREQ)) 
+		{	
+			if (rf95.recv(buf, &len))
+   			{
+				traceRadio(false, millis(), buf, len);
+				if (syncBeacon(buf, len)){
+					Serial.println("DEBUG: beacon received from LoRa");
+					return "";
+				}
+      				Serial.print("DEBUG: received from LoRA : ");
+				Serial.println((char*)buf);
+			      	//Serial.print("RSSI: ");
+			      	//Serial.println(rf95.lastRssi(), DEC);    
+			}else{
+				Serial.println("DEBUG: recv failed!");
+			}
+		}else{
+			Serial.println("DEBUG: No reply recv from LoRa module!");
+		}
+		return (char*)buf;
+	}
+		
+	//!******************************************************************************
+	//!	Name:	setNodeId()							*
+	//!	Description: set the node identifier of the telemetry frames		*
+	//!	Param : uint16_t with the identifier					*
+	//!	Returns: void								*
+	//!	Example: platform.setNodeId(7);						*
+	//!******************************************************************************
+	void platformClass::setNodeId(uint16_t id)
+	{
+		platformClass::nodeId = id;
+	}
+
+	//!******************************************************************************
+	//!	Name:	sendSample()							*
+	//!	Description: send a sample as a TelemetryFrame (frame.h) through the	*
+	//!	LORA module. Each frame carries the node identifier and a sequence	*
+	//!	number so that the gateway can discard duplicates and reorder them.	*
+	//!	The sequence starts again after a reset, so the frames also carry	*
+	//!	an epoch drawn at the first one, different after every reset.		*
+	//!	With ADR the frame goes with the setting told by the gateway in the	*
+	//!	previous acknowledgement, and waits for the next one. With TDMA, out	*
+	//!	of the slot of the node the sample is kept, as by sendLoRa(), and	*
+	//!	it returns LORA_WAIT; the frame is counted when it is sent.		*
+	//!	Param : Sample to send							*
+	//!	Returns: int with the success (0), LORA_WAIT or fail (-1)		*
+	//!	Example: platform.sendSample(s);					*
+	//!******************************************************************************
+	int platformClass::sendSample(const Sample &s)
+	{
+		int result;
+
+		if (!ensure(PERIPHERAL_LORA)){
+			return -1;
+		}
+		result = (sendPending() == LORA_WAIT) ? LORA_WAIT : transmitSample(s);
+		if (result == LORA_WAIT){
+			keepPending();
+			pendingKind = PENDING_SAMPLE;
+			pendingSample = s;
+		}
+		return result;
+	}
+
+	//!******************************************************************************
+	//!	Name:	sendPending()							*
+	//!	Description: send the packet kept by sendLoRa() or sendSample() out	*
+	//!	of the TDMA slot, if the slot of the node is on. A sketch that		*
+	//!	sleeps until getSlotWait() calls it when it wakes up; otherwise the	*
+	//!	next send or drain sends it.						*
+	//!	Param : void								*
+	//!	Returns: int with the success (0, also if none was kept), LORA_WAIT	*
+	//!	if it is still out of the slot or fail (-1), and then it is dropped	*
+	//!	Example: platform.sendPending();					*
+	//!******************************************************************************
+	int platformClass::sendPending(void)
+	{
+		int result;
+
+		switch (pendingKind){
+			case PENDING_TEXT:
+				result = transmitText(pendingText);
+				break;
+			case PENDING_SAMPLE:
+				result = transmitSample(pendingSample);
+				break;
+			default:
+				return 0;
+		}
+		if (result != LORA_WAIT){
+			pendingKind = PENDING_NONE;
+			pendingText = "";
+		}
+		return result;
+	}
+
+	//!******************************************************************************
+	//!	Name:	forwardLoRa()							*
+	//!	Description: copy a packet received through the LORA module to	*
+	//!	Serial as raw bytes, without waiting for it. Used by the gateway	*
+	//!	node attached to the host ingest (tools/gateway). With ADR it listens	*
+	//!	with the setting of the node whose slot is going on and acknowledges	*
+	//!	the telemetry frames.							*
+	//!	Param : void								*
+	//!	Returns: int with the bytes forwarded, 0 if none or -1 if fail		*
+	//!	Example: platform.forwardLoRa();					*
+	//!******************************************************************************
+	int platformClass::forwardLoRa(void)
+	{
+		uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
+		uint8_t len = sizeof(buf);
+		unsigned long received;
+
+		if (!ensure(PERIPHERAL_LORA)){
+			return -1;
+		}
+		digitalWrite(CS_SD, HIGH);	   //Disable SD
+		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
+		if (platformClass::adrEnabled){
+			followSlot();
+		}
+		if (!rf95.available()){
+			return 0;
+		}
+		if (!rf95.recv(buf, &len)){
+			return -1;
+		}
+		received = millis();
+		Serial.write(buf, len);
+		if (platformClass::adrEnabled){
+			acknowledge(buf, len);
+		}
+		traceRadio(false, received, buf, len);
+		return len;
+	}
+
+	//!******************************************************************************
+	//!	Name:	enableTDMA()							*
+	//!	Description: From now on sendLoRa() and sendSample() wait for the	*
+	//!	time slot of the node (setNodeId() % slots), so that the nodes do	*
+	//!	not collide. The network time is taken from the RTC, at the tick of	*
+	//!	a second, and corrected with the beacons received by receiveLoRa().	*
+	//!	The gateway enables it too, to stamp its beacons.			*
+	//!	Param : slots per frame, slot length (ms) and guard time (ms)		*
+	//!	Returns: int with the success (0) or fail (-1) of the sync with RTC	*
+	//!	Example: platform.enableTDMA(32, 2000, 200);				*
+	//!******************************************************************************
+	int platformClass::enableTDMA(uint16_t slots, uint16_t slotLength, uint16_t guard)
+	{
+		unsigned long start = millis();
+		uint32_t second;
+
+		tdma.configure(platformClass::nodeId, slots, slotLength, guard);
+		platformClass::tdmaEnabled = true;
+		if (!ensure(PERIPHERAL_RTC)){
+			Serial.println("DEBUG: TDMA waits for a beacon!");
+			return -1;
+		}
+		// The RTC counts seconds: wait for the next one to know the milliseconds
+		holdAcquisition();
+		second = platformClass::rtc.now().unixtime();
+		while (platformClass::rtc.now().unixtime() == second){
+			if (millis() - start > 1100){
+				releaseAcquisition();
+				return -1;
+			}
+		}
+		releaseAcquisition();
+		tdma.correct((uint64_t)(second + 1) * 1000, localTime());
+		return 0;
+	}
+
+	//!******************************************************************************
+	//!	Name:	disableTDMA()							*
+	//!	Description: transmissions are not delayed to the slot any more	*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.disableTDMA();					*
+	//!******************************************************************************
+	void platformClass::disableTDMA(void)
+	{
+		platformClass::tdmaEnabled = false;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getSlotWait()							*
+	//!	Description: Returns how long sendSample() would return LORA_WAIT:	*
+	//!	the ms until a frame, with the setting of the last one, fits in the	*
+	//!	slot of the node. The sketch can sample or sleep meanwhile, and	*
+	//!	then call sendPending() for a sample kept out of the slot.		*
+	//!	Param : void								*
+	//!	Returns: uint32_t with the ms, 0 if now or without TDMA		*
+	//!	Example: delay(platform.getSlotWait()); platform.sendPending();	*
+	//!******************************************************************************
+	uint32_t platformClass::getSlotWait(void)
+	{
+		return slotWait(frameSlot());
+	}
+
+	//!******************************************************************************
+	//!	Name:	sendBeacon()							*
+	//!	Description: broadcast a BeaconFrame (frame.h) with the network time	*
+	//!	so that the nodes correct the drift of their clocks			*
+	//!	Param : void								*
+	//!	Returns: int with the success (0) or fail (-1) of the sending		*
+	//!	Example: platform.sendBeacon();						*
+	//!******************************************************************************
+	int platformClass::sendBeacon(void)
+	{
+		BeaconFrame beacon;
+		unsigned long sent;
+
+		if (!ensure(PERIPHERAL_LORA)){
+			return -1;
+		}
+		beacon.sync[0] = FRAME_SYNC0;
+		beacon.sync[1] = FRAME_SYNC1;
+		beacon.version = FRAME_VERSION;
+		beacon.length = sizeof(beacon);
+		tune(ADR_DEFAULT, 0);
+		digitalWrite(CS_SD, HIGH);	   //Disable SD
+		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
+		beacon.time = tdma.networkTime(localTime());
+		beacon.crc = frameCRC((uint8_t*)&beacon, offsetof(BeaconFrame, crc));
+		sent = millis();
+		if (!rf95.send((uint8_t*)&beacon, sizeof(beacon))){
+			Serial.println("DEBUG: Sending beacon failed!");
+			return -1;
+		}
+		rf95.waitPacketSent();
+		traceRadio(true, sent, (const uint8_t*)&beacon, sizeof(beacon));
+		return 0;
+	}
+
+	//!******************************************************************************
+	//!	Name:	enableADR()							*
+	//!	Description: Adaptive data rate (adr.h). The gateway acknowledges the	*
+	//!	frames with the modem setting and TX power that deliver them with	*
+	//!	the least energy, chosen from their SNR, and the nodes use them for	*
+	//!	the next frames. One radio demodulates one setting at a time, so the	*
+	//!	gateway listens to each node in its slot: without TDMA only the power	*
+	//!	adapts. With TDMA the nodes should send a frame in every slot, since	*
+	//!	the gateway takes an empty slot as a frame lost.			*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.enableADR();						*
+	//!******************************************************************************
+	void platformClass::enableADR(void)
+	{
+		platformClass::adrEnabled = true;
+	}
+
+	//!******************************************************************************
+	//!	Name:	disableADR()							*
+	//!	Description: frames are sent at the default setting and highest power	*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.disableADR();						*
+	//!******************************************************************************
+	void platformClass::disableADR(void)
+	{
+		platformClass::adrEnabled = false;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getLinkStats()							*
+	//!	Description: Returns the frames sent by sendSample() with ADR using a	*
+	//!	setting: airtime, energy per byte delivered and delivery ratio		*
+	//!	Param : setting (0 is SF12, ADR_DEFAULT SF7) and TX power level	*
+	//!	Returns: LinkStats							*
+	//!	Example: platform.getLinkStats(ADR_DEFAULT, 0).deliveryRatio;		*
+	//!******************************************************************************
+	LinkStats platformClass::getLinkStats(uint8_t rate, uint8_t level)
+	{
+		LinkStats stats;
+		adrSetting s = adrTotals.get(rate, level);
+
+		stats.spreadingFactor = (rate < ADR_RATES) ? adrRates[rate].sf : 0;
+		stats.bandwidth = (rate < ADR_RATES) ? adrRates[rate].bandwidth : 0;
+		stats.power = adrPower(level);
+		stats.sent = s.sent;
+		stats.delivered = s.acked;
+		stats.airtime = s.airtime;
+		stats.energyPerByte = s.bytes ? s.energy / s.bytes : NAN;
+		stats.deliveryRatio = s.sent ? (float)s.acked / s.sent : NAN;
+		return stats;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getTemperature()						*
+	//!	Description: Read the temperature sensor				*
+	//!	Param : void								*
+	//!	Returns: float with the temperature					*
+	//!	Example: platform.getTemperature();					*
+	//!******************************************************************************
+	float platformClass::getTemperature(void)
+	{
+		
+		char inChar;
+		String temp="";
+		Serial1.print(TEMPERATURE);
+		bool end=false;
+		while (!end){
+			while (Serial1.available()) {
+				inChar = (char)Serial1.read();
+				temp += inChar;
+				if (inChar == '\n') {
+					end = true;
+					break;
+				}
+				
+			}
+			if (end) {break;}
+		}
+		const char* foo = temp.c_str();
+		return trace(TRACE_TEMPERATURE, atof(foo));
+	}
+ 	
+	//!******************************************************************************
+	//!	Name:	getHumidity()							*
+	//!	Description: Read the humidity						*
+	//!	Param : void								*
+	//!	Returns: float with the humidity					*
+	//!	Example: platform.getHumidity();					*
+	//!******************************************************************************
+	float platformClass::getHumidity(void)
+	{
+
+		char inChar;
+		String hum="";
+		Serial1.print(HUMIDITY);
+		bool end=false;
+		while (!end){
+			while (Serial1.available()) {
+				inChar = (char)Serial1.read();
+				hum += inChar;
+				if (inChar == '\n') {
+					end = true;
+					break;
+				}
+				
+			}
+			if (end) {break;}
+		}
+		const char* foo = hum.c_str();
+		return trace(TRACE_HUMIDITY, atof(foo));
+	}
+	//!******************************************************************************
+	//!	Name:	getBatteryVoltage()						*
+	//!	Description: Read the battery voltage					*
+	//!	Param : void								*
+	//!	Returns: float with the battery voltage					*
+	//!	Example: platform.getBatteryVoltage();					*
+	//!******************************************************************************
+	float platformClass::getBatteryVoltage(void)
+	{
+		char inChar;
+		String batt="";
+		Serial1.print(BATTERYVOLT);
+		bool end=false;
+		while (!end){
+			while (Serial1.available()) {
+				inChar = (char)Serial1.read();
+				batt += inChar;
+				if (inChar == '\n') {
+					end = true;
+					break;
+				}
+				
+			}
+			if (end) {break;}
+		}
+		const char* foo = batt.c_str();
+		return trace(TRACE_NODE_BATTERY, atof(foo));
+	}
+	//!******************************************************************************
+	//!	Name:	getTime()							*
+	//!	Description: get the time in which a sample is collected		*
+	//!	Param : void								*
+	//!	Returns: String								*
+	//!	Example: platform.getTime();						*
+	//!******************************************************************************
+	String  platformClass::getTime()
+	{
+		char date[32];
+		
+		if (!ensure(PERIPHERAL_RTC)){
+			return "";
+		}
+		holdAcquisition();
+		DateTime now = platformClass::rtc.now(); //Obtener fecha y hora actual.
+		releaseAcquisition();
+
+		int day = now.day();
+		int month = now.month();
+		int year = now.year();
+		int hour = now.hour();
+		int minute = now.minute();
+		int second = now.second();
+
+		snprintf(date, sizeof(date), "%.2d.%.2d.%.4d %.2d:%.2d:%.2d", day, month, year, hour, minute, second);
+		return String( date );
+	}  
+	
+	//!******************************************************************************
+	//!	Name:	initINA0()							*
+	//!	Description: Initializes sensor INA0					*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.initINA0();						*
+	//!******************************************************************************
+	void platformClass::initINA0(void)
+	{
+		if (probeI2C(ADDRESS0, PERIPHERAL_INA0)){
+			holdAcquisition();
+			ina0.begin();
+			releaseAcquisition();
+		}
+	}
+
+
+	//!******************************************************************************
+	//!	Name:	getPanelCurrent()						*
+	//!	Description: Read the current sensor INA0				*
+	//!	Param : void								*
+	//!	Returns: float with the current of the panel				*
+	//!	Example: platform.getPanelCurrent();					*
+	//!******************************************************************************
+	float platformClass::getPanelCurrent(void)
+	{
+		float current=0.0;
+		if (!ensure(PERIPHERAL_INA0)){
+			return current;
+		}
+	
+		relay(PINSET);
+		delay(1000);   
+		holdAcquisition();
+		current = ina0.getCurrent_mA();
+		releaseAcquisition();
+		current = trace(TRACE_PANEL_CURRENT, current);
+		relay(PINUNSET);  
+		return current;
+	}
+	
+	
+	//!******************************************************************************
+	//!	Name:	initINA1()							*
+	//!	Description: Initializes sensor INA1					*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.initINA1();						*
+	//!******************************************************************************
+	void platformClass::initINA1(void)
+	{
+		if (probeI2C(ADDRESS1, PERIPHERAL_INA1)){
+			holdAcquisition();
+			ina1.begin();
+			releaseAcquisition();
+		}
+	}
+	//!******************************************************************************
+	//!	Name:	getLoadCurrent()						*
+	//!	Description: Read the current sensor INA1				*
+	//!	Param : void								*
+	//!	Returns: float with the load current 					*
+	//!	Example: platform.getLoadCurrent();					*
+	//!******************************************************************************
+	float platformClass::getLoadCurrent(void)
+	{
+		float current=0.0;
+		if (ensure(PERIPHERAL_INA1)){
+			holdAcquisition();
+			current = ina1.getCurrent_mA();
+			releaseAcquisition();
+			current = trace(TRACE_LOAD_CURRENT, current);
+		}
+		return current;
+	}
+	
+	//!******************************************************************************
+	//!	Name:	initINA2()							*
+	//!	Description: Initializes sensor INA2					*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.initINA2();						*
+	//!******************************************************************************
+	void platformClass::initINA2(void)
+	{
+		if (probeI2C(ADDRESS2, PERIPHERAL_INA2)){
+			holdAcquisition();
+			ina2.begin();
+			releaseAcquisition();
+		}
+	}
+	//!******************************************************************************
+	//!	Name:	getBatteryCurrent()						*
+	//!	Description: Read the current sensor INA2				*
+	//!	Param : void								*
+	//!	Returns: float with the current of the battery				*
+	//!	Example: platform.getBatteryCurrent();					*
+	//!******************************************************************************
+	float platformClass::getBatteryCurrent(void)
+	{
+		float current=0.0;
+		if (ensure(PERIPHERAL_INA2)){
+			holdAcquisition();
+			current = ina2.getCurrent_mA();
+			releaseAcquisition();
+			current = trace(TRACE_BATTERY_CURRENT, current);
+		}
+		return current;
+	}	
+
+
+
+	//!******************************************************************************
+	//!	Name:	getPanelPower()							*
+	//!	Description: Read the power from sensor INA0				*
+	//!	Param : void								*
+	//!	Returns: float with the power of the panel				*
+	//!	Example: platform.getPanelPower();					*
+	//!******************************************************************************
+	float platformClass::getPanelPower(void)
+	{
+		float power=0.0;
+		if (!ensure(PERIPHERAL_INA0)){
+			return power;
+		}
+		relay(PINSET);
+		delay(1000);   
+		holdAcquisition();
+		power = ina0.getPower_mW();
+		releaseAcquisition();
+		power = trace(TRACE_PANEL_POWER, power);
+		relay(PINUNSET);  
+		return power;
+	}
+	
+	
+	//!******************************************************************************
+	//!	Name:	getLoadPower()							*
+	//!	Description: Read the power from sensor INA1				*
+	//!	Param : void								*
+	//!	Returns: float with the load power 					*
+	//!	Example: platform.getLoadPower();					*
+	//!******************************************************************************
+	float platformClass::getLoadPower(void)
+	{
+		float power=0.0;
+
+		if (ensure(PERIPHERAL_INA1)){
+			holdAcquisition();
+			power = ina1.getPower_mW();
+			releaseAcquisition();
+			power = trace(TRACE_LOAD_POWER, power);
+		}
+		return power;
+	}
+	
+	//!******************************************************************************
+	//!	Name:	getBatteryPower()						*
+	//!	Description: Read the power from sensor INA2				*
+	//!	Param : void								*
+	//!	Returns: float with the power of the battery				*
+	//!	Example: platform.getBatteryPower();					*
+	//!******************************************************************************
+	float platformClass::getBatteryPower(void)
+	{
+		float power=0.0;
+
+		if (ensure(PERIPHERAL_INA2)){
+			holdAcquisition();
+			power = ina2.getPower_mW();
+			releaseAcquisition();
+			power = trace(TRACE_BATTERY_POWER, power);
+		}
+		return power;
+	}	
+	
+
+	
+	//!******************************************************************************
+	//!	Name:	getSpeedOfWind()						*
+	//!	Description: Returns the speed of the wind (ANENOMETER)			*
+	//!	Param : void								*
+	//!	Returns: float with the ANENOMETER value in meters per second		*
+	//!	Example: platform.getSpeedOfWind();					*
+	//!******************************************************************************
+	float  platformClass::getSpeedOfWind(void)
+	{
+		float windOfSpeed = 0.0;
+		
+		//Reading from ANENOMETER and conversion to meters/second according to the datasheet 
+		//While capturing, the last reading of the timer avoids sharing the ADC
+		if (platformClass::capturingWind){
+			return trace(TRACE_WIND, WIND_SPEED(anenometer.last()));
+		}
+		holdAcquisition();
+		windOfSpeed = WIND_SPEED(analogRead(ANENOMETER));
+		releaseAcquisition();
+		return trace(TRACE_WIND, windOfSpeed);
+	}
+
+	//!******************************************************************************
+	//!	Name:	startWindCapture()						*
+	//!	Description: Starts timer TC3 to read the ANENOMETER WIND_RATE times	*
+	//!	per second in the background. getWindStats() returns what happened	*
+	//!	since the previous call, so the wind is not aliased by the moment	*
+	//!	of the sample. Only available on SAMD boards.				*
+	//!	Param : void								*
+	//!	Returns: int with the success (0) or fail (-1) if not supported	*
+	//!	Example: platform.startWindCapture();					*
+	//!******************************************************************************
+	int  platformClass::startWindCapture(void)
+	{
+#ifdef ARDUINO_ARCH_SAMD
+		windTotals discard;
+
+		// TC3 clocked by GCLK0 (48 MHz) / 1024, match frequency mode
+		GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TCC2_TC3));
+		while (GCLK->STATUS.bit.SYNCBUSY);
+		TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+		TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV1024;
+		while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+		TC3->COUNT16.CC[0].reg = (uint16_t)(SystemCoreClock / 1024 / WIND_RATE - 1);
+		while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+		TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+		anenometer.take(discard);
+		platformClass::capturingWind = true;
+		NVIC_EnableIRQ(TC3_IRQn);
+		TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+		while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+		return 0;
+#else
+		Serial.println("DEBUG: Wind capture not supported!");
+		return -1;
+#endif
+	}
+
+	//!******************************************************************************
+	//!	Name:	stopWindCapture()						*
+	//!	Description: Stops the background reading of the ANENOMETER		*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.stopWindCapture();					*
+	//!******************************************************************************
+	void  platformClass::stopWindCapture(void)
+	{
+#ifdef ARDUINO_ARCH_SAMD
+		NVIC_DisableIRQ(TC3_IRQn);
+		TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+#endif
+		platformClass::capturingWind = false;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getWindStats()							*
+	//!	Description: Returns the statistics of the readings of the		*
+	//!	ANENOMETER since the previous call: average, minimum, maximum, gust	*
+	//!	(highest mean over WIND_GUST seconds), deviation and turbulence	*
+	//!	Param : WindStats							*
+	//!	Returns: int 0 if success and -1 if there are no readings		*
+	//!	Example: platform.getWindStats(stats);					*
+	//!******************************************************************************
+	int  platformClass::getWindStats(WindStats &stats)
+	{
+		windTotals t;
+		float mean, variance;
+
+		if (!platformClass::capturingWind){
+			return -1;
+		}
+#ifdef ARDUINO_ARCH_SAMD
+		NVIC_DisableIRQ(TC3_IRQn);
+		anenometer.take(t);
+		NVIC_EnableIRQ(TC3_IRQn);
+#else
+		anenometer.take(t);
+#endif
+		stats.samples = t.count;
+		if (t.count == 0){
+			return -1;
+		}
+		// Readings are linear with the speed: convert the statistics of the readings
+		mean = (float)t.sum / t.count;
+		variance = (float)t.squares / t.count - mean * mean;
+		stats.average = trace(TRACE_WIND, WIND_SPEED(mean));
+		stats.minimum = WIND_SPEED(t.low);
+		stats.maximum = WIND_SPEED(t.high);
+		stats.gust = t.gust ? WIND_SPEED((float)t.gust / t.gustSamples) : NAN;
+		stats.deviation = (variance > 0) ? sqrt(variance) * AUX1 * AUX2 : 0.0;
+		stats.turbulence = (stats.average > 0) ? stats.deviation / stats.average : 0.0;
+		return 0;
+	}
+
+	//!******************************************************************************
+	//!	Name:	startAcquisition()						*
+	//!	Description: Starts timer TC4 to take snapshots of the load and	*
+	//!	battery INA219 and of the anenometer every period ms, in the		*
+	//!	background. They wait in a queue (sampleQueue.h) until the loop	*
+	//!	calls drainSamples(), so writing the SD or sending does not delay	*
+	//!	them. The foreground holds the timer while it uses the I2C bus or	*
+	//!	the ADC. Only available on SAMD boards.				*
+	//!	Param : ms between snapshots, SAMPLE_* flags of the channels		*
+	//!	Returns: int with the success (0) or fail (-1) if not supported	*
+	//!	Example: platform.startAcquisition(1000);				*
+	//!******************************************************************************
+	int  platformClass::startAcquisition(uint16_t period, uint16_t sources)
+	{
+#ifdef ARDUINO_ARCH_SAMD
+		// The peripherals are initialized here, the interrupt only reads them
+		sources &= SAMPLE_LOAD | SAMPLE_BATTERY | SAMPLE_WIND;
+		if ((sources & SAMPLE_LOAD) and !ensure(PERIPHERAL_INA1)){
+			sources &= ~SAMPLE_LOAD;
+		}
+		if ((sources & SAMPLE_BATTERY) and !ensure(PERIPHERAL_INA2)){
+			sources &= ~SAMPLE_BATTERY;
+		}
+		if ((sources == 0) or (period < ACQUIRE_TICK)){
+			Serial.println("DEBUG: Nothing to acquire!");
+			return -1;
+		}
+		stopAcquisition();
+		acquirePeriod = period;
+		acquireSources = sources;
+		acquireLast = millis() - period;
+
+		// TC4 clocked by GCLK0 (48 MHz) / 1024, match frequency mode, every ACQUIRE_TICK ms
+		GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TC4_TC5));
+		while (GCLK->STATUS.bit.SYNCBUSY);
+		TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+		TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV1024;
+		while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+		TC4->COUNT16.CC[0].reg = (uint16_t)(SystemCoreClock / 1024 / (1000 / ACQUIRE_TICK) - 1);
+		while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+		TC4->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+		// TC3 too, so the capture of the wind and the snapshots never preempt each other on the ADC
+		NVIC_SetPriority(TC3_IRQn, ACQUIRE_PRIORITY);
+		NVIC_SetPriority(TC4_IRQn, ACQUIRE_PRIORITY);
+		platformClass::acquiring = true;
+		NVIC_EnableIRQ(TC4_IRQn);
+		TC4->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+		while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+		return 0;
+#else
+		(void)period;
+		(void)sources;
+		Serial.println("DEBUG: Acquisition not supported!");
+		return -1;
+#endif
+	}
+
+	//!******************************************************************************
+	//!	Name:	stopAcquisition()						*
+	//!	Description: Stops the snapshots of timer TC4. Those queued are	*
+	//!	kept for drainSamples()							*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.stopAcquisition();					*
+	//!******************************************************************************
+	void  platformClass::stopAcquisition(void)
+	{
+#ifdef ARDUINO_ARCH_SAMD
+		NVIC_DisableIRQ(TC4_IRQn);
+		TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+#endif
+		platformClass::acquiring = false;
+	}
+
+	//!******************************************************************************
+	//!	Name:	drainSamples()							*
+	//!	Description: Takes the snapshots queued when it is called, so the	*
+	//!	timer filling the queue meanwhile does not keep it here, and turns	*
+	//!	each one into a Sample dated with the RTC. With DRAIN_SD every one	*
+	//!	is written with writeSample(), which packs the lines in the block	*
+	//!	in RAM, and the log is synced once at the end: a drain fills as few	*
+	//!	blocks as its lines need. With DRAIN_LORA the last one is sent with	*
+	//!	sendSample(), since a frame per snapshot would not fit in the		*
+	//!	airtime. Fields not taken are NAN.					*
+	//!	Param : DRAIN_* flags							*
+	//!	Returns: int with the snapshots drained or -1 if a write or the	*
+	//!	sending failed								*
+	//!	Example: platform.drainSamples(DRAIN_SD | DRAIN_LORA);			*
+	//!******************************************************************************
+	int  platformClass::drainSamples(uint8_t outputs)
+	{
+		queuedSample q;
+		Sample s;
+		uint16_t pending = snapshots.size();
+		uint32_t unixtime = 0, now, age;
+		bool clock = ensure(PERIPHERAL_RTC);
+		bool fail = false;
+		int drained = 0;
+
+		if (clock){
+			holdAcquisition();
+			unixtime = platformClass::rtc.now().unixtime();
+			releaseAcquisition();
+		}
+		if (pendingKind != PENDING_NONE){
+			sendPending();
+		}
+		now = millis();
+		while ((drained < pending) and snapshots.pop(q)){
+			// Snapshots taken after now are dated now
+			age = ((int32_t)(now - q.time) > 0) ? now - q.time : 0;
+			s.time = clock ? unixtime - age / 1000 : 0;
+			s.cycle = 0;
+			s.valid = q.valid | (clock ? SAMPLE_TIME : 0);
+			s.panelCurrent = s.panelPower = NAN;
+			s.loadCurrent = s.loadPower = NAN;
+			s.batteryCurrent = s.batteryPower = NAN;
+			s.temperature = s.humidity = s.batteryVoltage = NAN;
+			s.windSpeed = NAN;
+			if (q.valid & SAMPLE_LOAD){
+				s.loadCurrent = trace(TRACE_LOAD_CURRENT, q.loadCurrent);
+				s.loadPower = trace(TRACE_LOAD_POWER, q.loadPower);
+			}
+			if (q.valid & SAMPLE_BATTERY){
+				s.batteryCurrent = trace(TRACE_BATTERY_CURRENT, q.batteryCurrent);
+				s.batteryPower = trace(TRACE_BATTERY_POWER, q.batteryPower);
+			}
+			if (q.valid & SAMPLE_WIND){
+				s.windSpeed = trace(TRACE_WIND, WIND_SPEED(q.wind));
+			}
+			if ((outputs & DRAIN_SD) and (writeSample(s) != 0)){
+				fail = true;
+			}
+			drained++;
+		}
+		if ((outputs & DRAIN_SD) and drained and (flush() != 0)){
+			fail = true;
+		}
+		// Out of the slot the snapshot is kept, until a later call sends it or a newer one
+		if ((outputs & DRAIN_LORA) and drained and (sendSample(s) < 0)){
+			fail = true;
+		}
+		return fail ? -1 : drained;
+	}
+
+	//!******************************************************************************
+	//!	Name:	getQueueStats()							*
+	//!	Description: Returns the snapshots taken by the background		*
+	//!	acquisition, those dropped because the queue was full and the most	*
+	//!	queued at once, to size the period and the drains			*
+	//!	Param : void								*
+	//!	Returns: QueueStats							*
+	//!	Example: platform.getQueueStats();					*
+	//!******************************************************************************
+	QueueStats  platformClass::getQueueStats(void)
+	{
+		QueueStats stats;
+
+		stats.taken = acquireTaken;
+		stats.overflows = snapshots.getOverflows();
+		stats.queued = snapshots.size();
+		stats.highWater = snapshots.getHighWater();
+		stats.capacity = QUEUE_SAMPLES;
+		return stats;
+	}
+	
+
+	//!******************************************************************************
+	//!	Name:	open()								*
+	//!	Description: open a file on the memory card. To WRITE, the file is a	*
+	//!	log of blocks (blocklog.h): a torn block left by a power loss is	*
+	//!	found in a few reads and writeline() goes on over it. A file that	*
+	//!	is not empty and does not start as a log, like an old text log, is	*
+	//!	not overwritten: the log goes to the first name free or of a log	*
+	//!	numbered after it, DATA1.LOG for DATA.LOG, within 8.3 characters.	*
+	//!	Param : filename, mode							*
+	//!	Returns: int 0 if ok and -1 if not ok					*
+	//!	Example: platform.open();						*
+	//!******************************************************************************
+	int  platformClass::open(String filename, int mode)
+	{
+		unsigned long start = millis();
+		String name = filename, suffix;
+		int dot = filename.indexOf('.');
+		String base = (dot < 0) ? filename : filename.substring(0, dot);
+		String extension = (dot < 0) ? String("") : filename.substring(dot);
+		
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		platformClass::logging = false;
+		if (ensure(PERIPHERAL_SD)){
+			if (mode == WRITE){
+				for (int n = 1; ; n++){
+					// Not FILE_WRITE: O_APPEND would move every block to the end
+					platformClass::file = SD.open(name, O_READ | O_WRITE | O_CREAT);
+					if (!platformClass::file){
+						Serial.println("DEBUG1: Open file failed!");
+						return -1;
+					}
+					sdBlocks probe(platformClass::file);
+					if (sdLog.owns(probe)){
+						break;
+					}
+					platformClass::file.close();
+					if (n > LOG_ROLLOVER){
+						Serial.println("DEBUG: The file is not a log!");
+						return -1;
+					}
+					// The number replaces the end of a base of 8 characters
+					suffix = String(n);
+					name = base.substring(0, (base.length() + suffix.length() > 8) ? 8 - suffix.length() : base.length()) + suffix + extension;
+				}
+				if (name != filename){
+					Serial.print("DEBUG: The file is not a log, writing to ");
+					Serial.println(name);
+				}
+				sdBlocks store(platformClass::file);
+				sdLog.recover(store);
+				platformClass::boot.recovery = millis() - start;
+				platformClass::logging = true;
+				Serial.print("DEBUG: Log resumed at block ");
+				Serial.println(sdLog.getNext());
+			}else{
+				platformClass::file = SD.open(filename);
+				if (!platformClass::file){
+					Serial.println("DEBUG: Open file failed!");
+					return -1;
+				}
+			}
+			return 0;
+		}else{
+			Serial.println("DEBUG: Open file failed!");
+		}
+		return -1;
+		
+	
+	}
+	
+	
+	//!******************************************************************************
+	//!	Name:	close()								*
+	//!	Description: close a file, writing first the lines of the log kept	*
+	//!	in RAM									*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.close();						*
+	//!******************************************************************************
+	void  platformClass::close()
+	{
+		flush();
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		if (platformClass::file){
+			platformClass::file.close();
+		}
+		platformClass::logging = false;
+	}  
+	
+	//!******************************************************************************
+	//!	Name:	write()								*
+	//!	Description: write a line into the log on the memory card SD. Lines	*
+	//!	are packed in a block in RAM, written when it is full: a power loss	*
+	//!	loses at most the lines of that block. Call flush() to write them	*
+	//!	before sleeping or when they must be on the card.			*
+	//!	Param : String to write							*
+	//!	Returns: 0 if success or -1 if fail					*
+	//!	Example: platform.writeln();						*
+	//!******************************************************************************
+	int  platformClass::writeline(String data)
+	{
+		sdBlocks store(platformClass::file);
+
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		if (platformClass::file and platformClass::logging){
+			data += "\r\n";
+			return sdLog.append(store, data.c_str(), data.length());
+		}
+		return -1;
+		
+	}
+
+	//!******************************************************************************
+	//!	Name:	flush()								*
+	//!	Description: write the lines of the log kept in RAM to the memory	*
+	//!	card SD. The next lines start a new block, so flushing after every	*
+	//!	line takes a block per line.						*
+	//!	Param : void								*
+	//!	Returns: 0 if success or -1 if fail					*
+	//!	Example: platform.flush();						*
+	//!******************************************************************************
+	int  platformClass::flush(void)
+	{
+		sdBlocks store(platformClass::file);
+
+		if (!platformClass::file or !platformClass::logging){
+			return -1;
+		}
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		return sdLog.sync(store);
+	}
+	
+	//!******************************************************************************
+	//!	Name:	readline()							*
+	//!	Description: read data from memory card SD				*
+	//!	Param : File to read							*
+	//!	Returns: String with the data 						*
+	//!	Example: platform.readline();						*
+	//!******************************************************************************
+	String  platformClass::readline()
+	{
+		String data="";
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		if ((platformClass::file) and (platformClass::file.available())){
+			data = file.read();
+		}
+		return data;
+	}
+
+	//!******************************************************************************
+	//!	Name:	startTrace()							*
+	//!	Description: record the readings of the hardware and the packets of	*
+	//!	the radio in a trace (trace.h), a block log of its own on the SD.	*
+	//!	The records are kept in RAM until a block is full, so tracing	*
+	//!	does not write every sample; call flushTrace() before sleeping.	*
+	//!	Param : filename							*
+	//!	Returns: int 0 if ok and -1 if not ok					*
+	//!	Example: platform.startTrace("TRACE.LOG");				*
+	//!******************************************************************************
+	int  platformClass::startTrace(String filename)
+	{
+		uint32_t unixtime = 0;
+
+		if (tracer){
+			Serial.println("DEBUG: Already tracing!");
+			return -1;
+		}
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		if (!ensure(PERIPHERAL_SD)){
+			Serial.println("DEBUG: Open trace failed!");
+			return -1;
+		}
+		recorder.file = SD.open(filename, O_READ | O_WRITE | O_CREAT);
+		if (!recorder.file){
+			Serial.println("DEBUG: Open trace failed!");
+			return -1;
+		}
+		sdBlocks store(recorder.file);
+		if (recorder.recover() != 0){
+			Serial.println("DEBUG: The file is not a trace!");
+			recorder.file.close();
+			return -1;
+		}
+		if (ensure(PERIPHERAL_RTC)){
+			holdAcquisition();
+			unixtime = rtc.now().unixtime();
+			releaseAcquisition();
+		}
+		tracer = &recorder;
+		tracer->start(unixtime);
+		return 0;
+	}
+
+	//!******************************************************************************
+	//!	Name:	flushTrace()							*
+	//!	Description: write the records of the trace kept in RAM to the SD	*
+	//!	Param : void								*
+	//!	Returns: int 0 if ok and -1 if not ok					*
+	//!	Example: platform.flushTrace();						*
+	//!******************************************************************************
+	int  platformClass::flushTrace(void)
+	{
+		if (tracer != &recorder){
+			return -1;
+		}
+		return recorder.flush();
+	}
+
+	//!******************************************************************************
+	//!	Name:	stopTrace()							*
+	//!	Description: flush the trace and close its file, or drop the	*
+	//!	backend given with setTracer()						*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.stopTrace();						*
+	//!******************************************************************************
+	void  platformClass::stopTrace(void)
+	{
+		if (tracer == &recorder){
+			recorder.flush();
+			recorder.file.close();
+		}
+		tracer = NULL;
+	}
+
+	//!******************************************************************************
+	//!	Name:	setTracer()							*
+	//!	Description: give the readings and radio events to another backend,	*
+	//!	as the replay of tools/replay does on a host				*
+	//!	Param : backend, NULL to stop						*
+	//!	Returns: void								*
+	//!	Example: platform.setTracer(&replayer);				*
+	//!******************************************************************************
+	void  platformClass::setTracer(traceBackend *backend)
+	{
+		stopTrace();
+		tracer = backend;
+	}
+	
+
+	//!******************************************************************************
+	//!	Name:	initializeDisplay()						*
+	//!	Description: Initialize the LCD						*
+	//!	Param : void								*
+	//!	Returns: void								*
+	//!	Example: platform.initializeDisplay();					*
+	//!******************************************************************************
+	void  platformClass::initializeDisplay(void)
+	{
+		if (!probeI2C(DISPLAY_ADDRESS, PERIPHERAL_DISPLAY)){
+			return;
+		}
+		holdAcquisition();
+		display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS);
+		releaseAcquisition();
+		clean();
+		display.println(WELCOME_MSG);
+		display.println(VERSION_MSG);
+		holdAcquisition();
+		display.display();
+		releaseAcquisition();
+		
+		Serial.println("DEBUG: Display Initialized!");
+	}
+	
+	//!******************************************************************************
+	//!	Name:	displayLCD()							*
+	//!	Description: Display data on screen					*
+	//!	Param : String with the title and 					*
+	//!	Param : String with the data 						*
+	//!	Returns: void								*
+	//!	Example: platform.displayLCD();						*
+	//!******************************************************************************
+	void  platformClass::displayLCD(String title, String data)
+	{	
+		if (!ensure(PERIPHERAL_DISPLAY)){
+			return;
+		}
+		clean();
+		
+		display.print(title);
+		display.print(':');
+		display.print(data);
+		holdAcquisition();
+		display.display();
+		releaseAcquisition();
+	}
+
+	//! This function will read the temperature sensor of IoTnode 
+	float platformClass::readTemperature(){
+		uint16_t raw;
+		if (measureSHT1x(SHT1X_TEMPERATURE, raw) != CLIMATE_OK) {
+			return -1000.0;
+		} 
+		return SHT1X_D1 + SHT1X_D2*raw;
+	}
+	//! This function will read the humidity sensor of IoTnode 
+	float platformClass::readHumidity(){	
+		float t, rh;
+		if (readClimate(t, rh) != CLIMATE_OK) {
+			return -1.0;
+		} else { 
+    		return rh;
+		}
+	}
+
+	//!******************************************************************************
+	//!	Name:	readClimate()							*
+	//!	Description: Read temperature and humidity of the SHT1x with one	*
+	//!	conversion each. It waits for the conversions.				*
+	//!	Param : float temperature (C) and float humidity (%)			*
+	//!	Returns: int CLIMATE_OK or the CLIMATE_* error				*
+	//!	Example: platform.readClimate(t, rh);					*
+	//!******************************************************************************
+	int platformClass::readClimate(float &t, float &rh)
+	{
+		int status = startClimate();
+
+		if (status != CLIMATE_OK){
+			return status;
+		}
+		while ((status = pollClimate(t, rh)) == CLIMATE_BUSY){
+			delay(1);
+		}
+		return status;
+	}
+
+	//!******************************************************************************
+	//!	Name:	startClimate()							*
+	//!	Description: Start the temperature conversion of the SHT1x. Use	*
+	//!	pollClimate() to complete the measurement.				*
+	//!	Param : void								*
+	//!	Returns: int CLIMATE_OK or CLIMATE_NO_ACK				*
+	//!	Example: platform.startClimate();					*
+	//!******************************************************************************
+	int platformClass::startClimate(void)
+	{
+		int status = commandSHT1x(SHT1X_TEMPERATURE);
+		platformClass::climateState = (status == CLIMATE_OK) ? SHT1X_TEMPERATURE : SHT1X_IDLE;
+		platformClass::climateStarted = millis();
+		return status;
+	}
+
+	//!******************************************************************************
+	//!	Name:	pollClimate()							*
+	//!	Description: Advance the climate measurement without waiting. When	*
+	//!	the temperature is converted the humidity conversion is started, and	*
+	//!	when both are done the values are returned. If no measurement is	*
+	//!	in progress a new one is started.					*
+	//!	Param : float temperature (C) and float humidity (%)			*
+	//!	Returns: int CLIMATE_OK, CLIMATE_BUSY or the CLIMATE_* error		*
+	//!	Example: while (platform.pollClimate(t, rh) == CLIMATE_BUSY) {...}	*
+	//!******************************************************************************
+	int platformClass::pollClimate(float &t, float &rh)
+	{
+		uint16_t raw;
+		int status;
+
+		if (platformClass::climateState == SHT1X_IDLE){
+			status = startClimate();
+			return (status == CLIMATE_OK) ? CLIMATE_BUSY : status;
+		}
+		if (!readySHT1x()){
+			if (millis() - platformClass::climateStarted < SHT1X_TIMEOUT){
+				return CLIMATE_BUSY;
+			}
+			platformClass::climateState = SHT1X_IDLE;
+			return CLIMATE_TIMEOUT;
+		}
+		raw = trace((platformClass::climateState == SHT1X_TEMPERATURE) ? TRACE_SHT_TEMPERATURE : TRACE_SHT_HUMIDITY, readSHT1x());
+		if (platformClass::climateState == SHT1X_TEMPERATURE){
+			platformClass::climateTemperature = SHT1X_D1 + SHT1X_D2*raw;
+			status = commandSHT1x(SHT1X_HUMIDITY);
+			if (status != CLIMATE_OK){
+				platformClass::climateState = SHT1X_IDLE;
+				return status;
+			}
+			platformClass::climateState = SHT1X_HUMIDITY;
+			platformClass::climateStarted = millis();
+			return CLIMATE_BUSY;
+		}
+		platformClass::climateState = SHT1X_IDLE;
+		t = platformClass::climateTemperature;
+		// Linear humidity compensated with the temperature just measured
+		rh = (t - 25.0)*(SHT1X_T1 + SHT1X_T2*raw) + SHT1X_C1 + SHT1X_C2*raw + SHT1X_C3*raw*raw;
+		return CLIMATE_OK;
+	}
+	//! This function will read the battery voltage of IoTnode 
+	
+	float platformClass::readBatteryVoltage(){	
+		float value;
+#ifdef ARDUINO_ARCH_SAMD
+		// The ADC is shared with the capture of the anenometer
+		if (platformClass::capturingWind){
+			NVIC_DisableIRQ(TC3_IRQn);
+			holdAcquisition();
+			value = analogRead(BATTERY) * AUX1;
+			releaseAcquisition();
+			NVIC_EnableIRQ(TC3_IRQn);
+			return trace(TRACE_BATTERY_VOLTAGE, value);
+		}
+#endif
+		holdAcquisition();
+		value = analogRead(BATTERY) * AUX1;
+		releaseAcquisition();
+		return trace(TRACE_BATTERY_VOLTAGE, value);
+	}
+	
+	//!******************************************************************************
+	//!	Name:	sample()							*
+	//!	Description: Collect a sample. The slow operations (panel relay and	*
+	//!	Serial1 queries) are started first and the other sensors are read	*
+	//!	meanwhile, so the cycle lasts about as much as the longest of them.	*
+	//!	Fields that could not be read are left as NAN. SAMPLE_CLIMATE and	*
+	//!	SAMPLE_WIND cannot be read together: both use pin A1.			*
+	//!	Param : Sample to fill and SAMPLE_* sources to read			*
+	//!	Returns: int 0 if every source was read and -1 if not			*
+	//!	Example: platform.sample(s, SAMPLE_TESTBED);				*
+	//!******************************************************************************
+	int platformClass::sample(Sample &s, uint16_t sources)
+	{
+		const char *question[3];
+		float *answer[3];
+		uint8_t kind[3];
+		int queries = 0;
+		int query = 0;
+		String line = "";
+		unsigned long start = millis();
+		unsigned long settle = 0;
+		unsigned long asked = 0;
+		bool panel = false;
+		bool climate = false;
+
+		s.time = 0;
+		s.valid = 0;
+		s.panelCurrent = s.panelPower = NAN;
+		s.loadCurrent = s.loadPower = NAN;
+		s.batteryCurrent = s.batteryPower = NAN;
+		s.temperature = s.humidity = s.batteryVoltage = NAN;
+		s.windSpeed = NAN;
+
+		// The data line of the SHT1x is the pin of the anenometer
+		if ((sources & SAMPLE_CLIMATE) and (sources & SAMPLE_WIND)){
+			Serial.println("DEBUG: SAMPLE_CLIMATE and SAMPLE_WIND share pin A1!");
+			return -1;
+		}
+		// A trace block that fills now is written once the cycle is measured
+		if (tracer == &recorder){
+			recorder.defer();
+		}
+		// Start the slow operations: the panel needs a second after the relay...
+		if ((sources & SAMPLE_PANEL) and ensure(PERIPHERAL_INA0)){
+			relay(PINSET);
+			settle = millis();
+			panel = true;
+		}
+		// ...and the node answers on Serial1 while the other sensors are read
+		if (sources & SAMPLE_NODE){
+			if (!(sources & SAMPLE_CLIMATE)){
+				question[queries] = TEMPERATURE;
+				kind[queries] = TRACE_TEMPERATURE;
+				answer[queries++] = &s.temperature;
+				question[queries] = HUMIDITY;
+				kind[queries] = TRACE_HUMIDITY;
+				answer[queries++] = &s.humidity;
+			}
+			question[queries] = BATTERYVOLT;
+			kind[queries] = TRACE_NODE_BATTERY;
+			answer[queries++] = &s.batteryVoltage;
+			while (Serial1.available()) {	// drop answers of a previous timeout
+				Serial1.read();
+			}
+			Serial1.print(question[0]);
+			asked = millis();
+		}
+		// ...and the SHT1x converts temperature and then humidity
+		if (sources & SAMPLE_CLIMATE){
+			climate = (startClimate() == CLIMATE_OK);
+		}
+
+		if ((sources & SAMPLE_TIME) and ensure(PERIPHERAL_RTC)){
+			holdAcquisition();
+			s.time = platformClass::rtc.now().unixtime();
+			releaseAcquisition();
+			s.valid |= SAMPLE_TIME;
+		}
+		if ((sources & SAMPLE_LOAD) and ensure(PERIPHERAL_INA1)){
+			holdAcquisition();
+			s.loadCurrent = ina1.getCurrent_mA();
+			s.loadPower = ina1.getPower_mW();
+			releaseAcquisition();
+			s.loadCurrent = trace(TRACE_LOAD_CURRENT, s.loadCurrent);
+			s.loadPower = trace(TRACE_LOAD_POWER, s.loadPower);
+			s.valid |= SAMPLE_LOAD;
+		}
+		if ((sources & SAMPLE_BATTERY) and ensure(PERIPHERAL_INA2)){
+			holdAcquisition();
+			s.batteryCurrent = ina2.getCurrent_mA();
+			s.batteryPower = ina2.getPower_mW();
+			releaseAcquisition();
+			s.batteryCurrent = trace(TRACE_BATTERY_CURRENT, s.batteryCurrent);
+			s.batteryPower = trace(TRACE_BATTERY_POWER, s.batteryPower);
+			s.valid |= SAMPLE_BATTERY;
+		}
+		if (sources & SAMPLE_WIND){
+			WindStats wind;
+			// The mean since the previous sample when the capture is running
+			s.windSpeed = (getWindStats(wind) == 0) ? wind.average : getSpeedOfWind();
+			s.valid |= SAMPLE_WIND;
+		}
+
+		// Complete the slow operations, reading the results as they arrive
+		while (panel or climate or (query < queries)){
+			if (climate){
+				switch (pollClimate(s.temperature, s.humidity)){
+					case CLIMATE_BUSY:
+						break;
+					case CLIMATE_OK:
+						s.valid |= SAMPLE_CLIMATE;
+						climate = false;
+						break;
+					default:
+						s.temperature = s.humidity = NAN;
+						climate = false;
+				}
+			}
+			if (panel and (millis() - settle >= PANEL_SETTLE)){
+				holdAcquisition();
+				s.panelCurrent = ina0.getCurrent_mA();
+				s.panelPower = ina0.getPower_mW();
+				releaseAcquisition();
+				s.panelCurrent = trace(TRACE_PANEL_CURRENT, s.panelCurrent);
+				s.panelPower = trace(TRACE_PANEL_POWER, s.panelPower);
+				relay(PINUNSET);
+				s.valid |= SAMPLE_PANEL;
+				panel = false;
+			}
+			if (query < queries){
+				if (pollSerial1(line)){
+					*answer[query] = trace(kind[query], atof(line.c_str()));
+					query++;
+					line = "";
+					if (query < queries){
+						Serial1.print(question[query]);
+						asked = millis();
+					}else{
+						s.valid |= SAMPLE_NODE;
+					}
+				}else if (millis() - asked >= SERIAL1_TIMEOUT){
+					Serial.println("DEBUG: No answer from node on Serial1!");
+					query = queries;
+				}
+			}
+		}
+		s.cycle = millis() - start;
+		if (!platformClass::boot.firstSample){
+			platformClass::boot.firstSample = millis();
+		}
+		if (tracer){
+			uint8_t summary[6];
+			memcpy(summary, &s.valid, 2);
+			memcpy(summary + 2, &s.cycle, 4);
+			tracer->event(TRACE_SAMPLE, millis(), summary, sizeof(summary));
+		}
+		if (tracer == &recorder){
+			recorder.resume();
+		}
+		return (s.valid == sources) ? 0 : -1;
+	}
+
+	//!******************************************************************************
+	//!	Name:	writeSample()							*
+	//!	Description: write a sample into memory card SD as a line with the	*
+	//!	date followed by the fields separated by commas (empty if NAN)		*
+	//!	Param : Sample to write							*
+	//!	Returns: 0 if success or -1 if fail					*
+	//!	Example: platform.writeSample(s);					*
+	//!******************************************************************************
+	int platformClass::writeSample(const Sample &s)
+	{
+		char date[32] = "";
+		String line;
+		const float fields[] = {s.panelCurrent, s.panelPower, s.loadCurrent, s.loadPower,
+			s.batteryCurrent, s.batteryPower, s.temperature, s.humidity,
+			s.batteryVoltage, s.windSpeed};
+
+		if (s.valid & SAMPLE_TIME){
+			DateTime t(s.time);
+			snprintf(date, sizeof(date), "%.2d.%.2d.%.4d %.2d:%.2d:%.2d", t.day(), t.month(), t.year(),
+				t.hour(), t.minute(), t.second());
+		}
+		line = date;
+		for (unsigned int i = 0; i < sizeof(fields)/sizeof(fields[0]); i++){
+			line += ',';
+			if (!isnan(fields[i])){
+				line += String(fields[i], 2);
+			}
+		}
+		return writeline(line);
+	}
+	
+//***************************************************************
+// Private Methods						*
+//***************************************************************
+
+		
+	//! This function will change the status of the relay:  
+	// Short circuit current of the panel: we close relay and wait 
+	//current be stablished again, then it puts the relay in its original state
+
+	void platformClass::relay(int status)
+	{
+		digitalWrite(status,HIGH);
+		delay(10);
+		digitalWrite(status,LOW);
+	}
+
+	//! This function will extend millis() to 64 bits, so that the slots keep
+	// their place after it wraps (49 days). It must run once in that period
+	uint64_t platformClass::localTime(void)
+	{
+		static uint32_t last = 0;
+		static uint32_t wraps = 0;
+		uint32_t now = millis();
+
+		if (now < last){
+			wraps++;
+		}
+		last = now;
+		return ((uint64_t)wraps << 32) | now;
+	}
+
+	//! This function will give a reading to the tracer, that records it or,
+	// in a replay, gives back the value to use instead
+	float platformClass::trace(uint8_t kind, float value)
+	{
+		return tracer ? tracer->reading(kind, value) : value;
+	}
+
+	//! This function will give a packet to the tracer: the setting and bytes
+	// of a packet sent, or the link quality and the packet received
+	void platformClass::traceRadio(bool sent, uint32_t time, const uint8_t *buf, uint8_t len)
+	{
+		uint8_t record[3 + RH_RF95_MAX_MESSAGE_LEN];
+		int16_t rssi;
+		int8_t snr;
+
+		if (!tracer){
+			return;
+		}
+		if (sent){
+			record[0] = platformClass::radioRate;
+			record[1] = platformClass::radioLevel;
+			record[2] = len;
+			tracer->event(TRACE_SEND, time, record, 3);
+			return;
+		}
+		rssi = rf95.lastRssi();
+		snr = rf95.lastSNR();
+		if (len > RH_RF95_MAX_MESSAGE_LEN){
+			len = RH_RF95_MAX_MESSAGE_LEN;
+		}
+		memcpy(record, &rssi, 2);
+		record[2] = snr;
+		memcpy(record + 3, buf, len);
+		tracer->event(TRACE_RECEIVE, time, record, 3 + len);
+	}
+
+	//! This function will return the ms on air of a packet of the given bytes,
+	// rounded up, with the setting of the radio. RadioHead sends its header first
+	uint32_t platformClass::airtime(uint8_t bytes)
+	{
+		const loraRate &r = adrRates[platformClass::radioRate];
+
+		return loraAirtime(bytes + RH_RF95_HEADER_LEN, r.sf, r.bandwidth, r.cr) / 1000 + 1;
+	}
+
+	//! This function will send a sample as a telemetry frame, or return
+	// LORA_WAIT out of the slot without counting it
+	int platformClass::transmitSample(const Sample &s)
+	{
+		TelemetryFrame frame;
+		const float fields[FRAME_FIELDS] = {s.panelCurrent, s.panelPower, s.loadCurrent, s.loadPower,
+			s.batteryCurrent, s.batteryPower, s.temperature, s.humidity,
+			s.batteryVoltage, s.windSpeed};
+		uint8_t rate = ADR_DEFAULT, level = 0;
+		unsigned long sent;
+
+		if (platformClass::adrEnabled){
+			// The settings the gateway can follow, see enableADR()
+			adr.allowRates(platformClass::tdmaEnabled);
+			rate = adr.getRate();
+			level = adr.getLevel();
+		}
+		if (platformClass::epoch == 0){
+			// The time of the RTC differs at every reset, micros() with the boot
+			uint32_t seed = micros();
+			if (platformClass::initialized & PERIPHERAL_RTC){
+				holdAcquisition();
+				seed ^= platformClass::rtc.now().unixtime();
+				releaseAcquisition();
+			}
+			platformClass::epoch = (uint16_t)(seed ^ (seed >> 16));
+			if (platformClass::epoch == 0){
+				platformClass::epoch = 1;
+			}
+		}
+		tune(rate, level);
+		// The acknowledgement must fit in the slot too
+		if (slotWait(frameSlot()) > 0){
+			return LORA_WAIT;
+		}
+		frame.sync[0] = FRAME_SYNC0;
+		frame.sync[1] = FRAME_SYNC1;
+		frame.version = FRAME_VERSION;
+		frame.length = sizeof(frame);
+		frame.node = platformClass::nodeId;
+		frame.epoch = platformClass::epoch;
+		frame.sequence = platformClass::sequence++;
+		frame.time = s.time;
+		frame.valid = s.valid;
+		frame.link = FRAME_LINK(rate, level);
+		memcpy(frame.fields, fields, sizeof(fields));
+		frame.crc = frameCRC((uint8_t*)&frame, offsetof(TelemetryFrame, crc));
+
+		digitalWrite(CS_SD, HIGH);	   //Disable SD
+		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
+		sent = millis();
+		if (!rf95.send((uint8_t*)&frame, sizeof(frame))){
+			Serial.println("DEBUG: Sending frame failed!");
+			return -1;
+		}
+		rf95.waitPacketSent();
+		if (platformClass::adrEnabled){
+			adrTotals.account(rate, level, sizeof(frame), waitAck(frame.sequence));
+		}
+		// Traced once the acknowledgement is in, a flush of the trace would miss it
+		traceRadio(true, sent, (const uint8_t*)&frame, sizeof(frame));
+		return 0;
+	}
+
+	//! This function will send a text message, or return LORA_WAIT out of the slot
+	int platformClass::transmitText(String data)
+	{
+		const char *msg=data.c_str();
+		unsigned long sent;
+
+		tune(ADR_DEFAULT, 0);
+		if (slotWait(airtime(data.length() + 1)) > 0){
+			return LORA_WAIT;
+		}
+		digitalWrite(CS_SD, HIGH);	   //Disable SD
+		digitalWrite(RFM95_CS, LOW);	   //Enable Lora 
+
+		Serial.print("DEBUG: Sending Message: ");
+		Serial.println(msg);
+		sent = millis();
+		rf95.send((uint8_t*)msg, data.length() + 1);
+	 	delay(10);
+		rf95.waitPacketSent();
+		traceRadio(true, sent, (const uint8_t*)msg, data.length() + 1);
+		return 0;
+	}
+
+	//! This function will make room for a packet out of the slot: only the
+	// last one is kept
+	void platformClass::keepPending(void)
+	{
+		if (pendingKind != PENDING_NONE){
+			Serial.println("DEBUG: Packet kept out of the slot replaced!");
+		}
+	}
+
+	//! This function will return, if TDMA is enabled, the ms until a
+	// transmission of the given ms fits in the slot of the node. It does not
+	// wait: a whole frame of slots would stop the sampling and the log
+	uint32_t platformClass::slotWait(uint32_t airtime)
+	{
+		if (!platformClass::tdmaEnabled){
+			return 0;
+		}
+		return tdma.wait(localTime(), airtime);
+	}
+
+	//! This function will return the ms a telemetry frame takes in the slot:
+	// its airtime and, with ADR, the turnaround and the acknowledgement
+	uint32_t platformClass::frameSlot(void)
+	{
+		uint32_t slot = airtime(sizeof(TelemetryFrame));
+
+		if (platformClass::adrEnabled){
+			slot += ADR_TURNAROUND + airtime(sizeof(AckFrame));
+		}
+		return slot;
+	}
+
+	//! This function will set the network time from a beacon. The beacon was
+	// stamped when its transmission started, so its airtime is added
+	bool platformClass::syncBeacon(const uint8_t *buf, uint8_t len)
+	{
+		BeaconFrame beacon;
+
+		if (len != sizeof(beacon)){
+			return false;
+		}
+		memcpy(&beacon, buf, sizeof(beacon));
+		if ((beacon.sync[0] != FRAME_SYNC0) or (beacon.sync[1] != FRAME_SYNC1) or
+				(beacon.version != FRAME_VERSION) or
+				(beacon.crc != frameCRC(buf, offsetof(BeaconFrame, crc)))){
+			return false;
+		}
+		tdma.correct(beacon.time + airtime(len) - 1, localTime());
+		return true;
+	}
+
+	//! This function will change the modem setting and the TX power of the
+	// radio, only if they are not the ones already set
+	void platformClass::tune(uint8_t rate, uint8_t level)
+	{
+		if (rate != platformClass::radioRate){
+			rf95.setSignalBandwidth(adrRates[rate].bandwidth);
+			rf95.setSpreadingFactor(adrRates[rate].sf);
+			rf95.setCodingRate4(adrRates[rate].cr + 4);
+			platformClass::radioRate = rate;
+		}
+		if (level != platformClass::radioLevel){
+			rf95.setTxPower(adrPower(level), false);
+			platformClass::radioLevel = level;
+		}
+	}
+
+	//! This function will wait for the acknowledgement of the frame with the
+	// given sequence and take the setting it carries. After ADR_MISSES frames
+	// without it the node falls back to the most robust setting, as the gateway does
+	bool platformClass::waitAck(uint16_t sequence)
+	{
+		uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
+		uint8_t len;
+		AckFrame ack;
+		unsigned long start = millis();
+		unsigned long timeout = ADR_TURNAROUND + airtime(sizeof(ack));
+		unsigned long received;
+
+		while (millis() - start < timeout){
+			len = sizeof(buf);
+			if (!rf95.waitAvailableTimeout(timeout - (millis() - start))){
+				break;
+			}
+			if (!rf95.recv(buf, &len) or (len != sizeof(ack))){
+				continue;
+			}
+			received = millis();
+			memcpy(&ack, buf, sizeof(ack));
+			if ((ack.sync[0] == FRAME_SYNC0) and (ack.sync[1] == FRAME_SYNC1) and
+					(ack.version == FRAME_VERSION) and
+					(ack.crc == frameCRC(buf, offsetof(AckFrame, crc))) and
+					(ack.node == platformClass::nodeId) and (ack.sequence == sequence)){
+				adr.set(ack.link >> 4, ack.link & 0x0F);
+				traceRadio(false, received, buf, len);
+				return true;
+			}
+		}
+		if (adr.missed()){
+			Serial.println("DEBUG: ADR back to the most robust setting!");
+		}
+		return false;
+	}
+
+	//! This function will acknowledge a telemetry frame received by the gateway
+	// with the setting chosen for the next frames of the node, from its SNR
+	void platformClass::acknowledge(const uint8_t *buf, uint8_t len)
+	{
+		TelemetryFrame frame;
+		AckFrame ack;
+		adrController *node;
+		unsigned long sent;
+
+		if (len != sizeof(frame)){
+			return;
+		}
+		memcpy(&frame, buf, sizeof(frame));
+		if ((frame.sync[0] != FRAME_SYNC0) or (frame.sync[1] != FRAME_SYNC1) or
+				(frame.version != FRAME_VERSION) or
+				(frame.crc != frameCRC(buf, offsetof(TelemetryFrame, crc)))){
+			return;
+		}
+		ack.sync[0] = FRAME_SYNC0;
+		ack.sync[1] = FRAME_SYNC1;
+		ack.version = FRAME_VERSION;
+		ack.length = sizeof(ack);
+		ack.node = frame.node;
+		ack.sequence = frame.sequence;
+		ack.rssi = rf95.lastRssi();
+		ack.snr = rf95.lastSNR();
+		ack.link = FRAME_LINK(ADR_DEFAULT, 0);
+		node = adrNode(platformClass::tdmaEnabled ? tdma.slotOf(frame.node) : frame.node);
+		if (node){
+			// Without slots the gateway can not follow other settings
+			node->allowRates(platformClass::tdmaEnabled);
+			node->heard(ack.snr, frame.link >> 4, frame.link & 0x0F);
+			node->decide(sizeof(frame));
+			ack.link = FRAME_LINK(node->getRate(), node->getLevel());
+		}
+		ack.crc = frameCRC((uint8_t*)&ack, offsetof(AckFrame, crc));
+		platformClass::adrHeard = true;
+		// The node listens with the setting of its frame
+		sent = millis();
+		if (!rf95.send((uint8_t*)&ack, sizeof(ack))){
+			Serial.println("DEBUG: Sending acknowledgement failed!");
+			return;
+		}
+		rf95.waitPacketSent();
+		traceRadio(true, sent, (const uint8_t*)&ack, sizeof(ack));
+	}
+
+	//! This function will set the radio of the gateway to the setting of the
+	// node whose slot is going on. A slot that ended without a frame counts
+	// as a frame lost by its node
+	void platformClass::followSlot(void)
+	{
+		adrController *node;
+		uint16_t slot;
+
+		if (!platformClass::tdmaEnabled){
+			tune(ADR_DEFAULT, 0);
+			return;
+		}
+		slot = tdma.currentSlot(localTime());
+		if (slot != platformClass::adrSlot){
+			node = adrNode(platformClass::adrSlot);
+			if (node and !platformClass::adrHeard and node->missed()){
+				Serial.println("DEBUG: ADR of a node back to the most robust setting!");
+			}
+			platformClass::adrSlot = slot;
+			platformClass::adrHeard = false;
+		}
+		node = adrNode(slot);
+		tune(node ? node->getRate() : ADR_DEFAULT, 0);
+	}
+
+	adrController *platformClass::adrNode(uint16_t index)
+	{
+		return (index < ADR_NODES) ? &adrNodes[index] : NULL;
+	}
+
+	//! This function will append to the line the characters received on Serial1,
+	// without waiting for more. It returns true once the end of line arrives
+	bool platformClass::pollSerial1(String &line)
+	{
+		char inChar;
+		while (Serial1.available()) {
+			inChar = (char)Serial1.read();
+			line += inChar;
+			if (inChar == '\n') {
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	//! This function will send a command to the SHT1x: transmission start
+	// sequence, the command (MSB first) and the acknowledge of the sensor,
+	// which pulls data low during the ninth clock and releases it after
+	int platformClass::commandSHT1x(uint8_t command)
+	{
+		bool ack;
+
+		pinMode(SHT1X_ADDRESS, OUTPUT);
+		pinMode(SHT1X_CONTROL, OUTPUT);
+		digitalWrite(SHT1X_ADDRESS, HIGH);
+		digitalWrite(SHT1X_CONTROL, HIGH);
+		digitalWrite(SHT1X_ADDRESS, LOW);
+		digitalWrite(SHT1X_CONTROL, LOW);
+		digitalWrite(SHT1X_CONTROL, HIGH);
+		digitalWrite(SHT1X_ADDRESS, HIGH);
+		digitalWrite(SHT1X_CONTROL, LOW);
+		for (int i = 7; i >= 0; i--){
+			digitalWrite(SHT1X_ADDRESS, (command >> i) & 1);
+			digitalWrite(SHT1X_CONTROL, HIGH);
+			delayMicroseconds(5);
+			digitalWrite(SHT1X_CONTROL, LOW);
+		}
+		pinMode(SHT1X_ADDRESS, INPUT);
+		digitalWrite(SHT1X_CONTROL, HIGH);
+		ack = (digitalRead(SHT1X_ADDRESS) == LOW);
+		digitalWrite(SHT1X_CONTROL, LOW);
+		if (!ack or (digitalRead(SHT1X_ADDRESS) == LOW)){
+			Serial.println("DEBUG: SHT1x did not acknowledge!");
+			return CLIMATE_NO_ACK;
+		}
+		return CLIMATE_OK;
+	}
+
+	//! This function will check if the SHT1x finished: it pulls data low
+	bool platformClass::readySHT1x(void)
+	{
+		pinMode(SHT1X_ADDRESS, INPUT);
+		return (digitalRead(SHT1X_ADDRESS) == LOW);
+	}
+
+	//! This function will read the two bytes of the SHT1x result, acknowledging
+	// the first one and leaving data high after the second to skip the CRC
+	uint16_t platformClass::readSHT1x(void)
+	{
+		uint16_t value = 0;
+
+		pinMode(SHT1X_CONTROL, OUTPUT);
+		for (int n = 0; n < 2; n++){
+			pinMode(SHT1X_ADDRESS, INPUT);
+			for (int i = 0; i < 8; i++){
+				digitalWrite(SHT1X_CONTROL, HIGH);
+				delayMicroseconds(5);
+				value = (value << 1) | digitalRead(SHT1X_ADDRESS);
+				digitalWrite(SHT1X_CONTROL, LOW);
+			}
+			pinMode(SHT1X_ADDRESS, OUTPUT);
+			digitalWrite(SHT1X_ADDRESS, (n == 0) ? LOW : HIGH);
+			digitalWrite(SHT1X_CONTROL, HIGH);
+			delayMicroseconds(5);
+			digitalWrite(SHT1X_CONTROL, LOW);
+		}
+		pinMode(SHT1X_ADDRESS, INPUT);
+		return value;
+	}
+
+	//! This function will run a conversion of the SHT1x waiting for the result
+	int platformClass::measureSHT1x(uint8_t command, uint16_t &value)
+	{
+		unsigned long start = millis();
+		int status = commandSHT1x(command);
+
+		platformClass::climateState = SHT1X_IDLE;	// a pending pollClimate() is lost
+		while ((status == CLIMATE_OK) and !readySHT1x()){
+			if (millis() - start >= SHT1X_TIMEOUT){
+				return CLIMATE_TIMEOUT;
+			}
+			delay(1);
+		}
+		if (status == CLIMATE_OK){
+			value = trace((command == SHT1X_TEMPERATURE) ? TRACE_SHT_TEMPERATURE : TRACE_SHT_HUMIDITY, readSHT1x());
+		}
+		return status;
+	}
+
+	//! This function will initialize a peripheral the first time it is needed,
+	// recording how long it took. A peripheral that failed is not tried again
+	bool platformClass::ensure(uint8_t peripheral)
+	{
+		unsigned long start;
+		uint16_t elapsed;
+
+		if (platformClass::initialized & peripheral){
+			return true;
+		}
+		if (platformClass::failed & peripheral){
+			return false;
+		}
+		start = millis();
+		switch (peripheral){
+			case PERIPHERAL_SD:	initializeSD(); break;
+			case PERIPHERAL_RTC:	platform.initializeRTC(); break;
+			case PERIPHERAL_LORA:	platform.initializeLoRa(); break;
+			case PERIPHERAL_DISPLAY:platform.initializeDisplay(); break;
+			case PERIPHERAL_INA0:	platform.initINA0(); break;
+			case PERIPHERAL_INA1:	platform.initINA1(); break;
+			case PERIPHERAL_INA2:	platform.initINA2(); break;
+		}
+		elapsed = millis() - start;
+		switch (peripheral){
+			case PERIPHERAL_SD:	platformClass::boot.sd = elapsed; break;
+			case PERIPHERAL_RTC:	platformClass::boot.rtc = elapsed; break;
+			case PERIPHERAL_LORA:	platformClass::boot.lora = elapsed; break;
+			case PERIPHERAL_DISPLAY:platformClass::boot.display = elapsed; break;
+			default:		platformClass::boot.ina += elapsed;
+		}
+		return (platformClass::initialized & peripheral);
+	}
+
+	//! This function will check that a device acknowledges its I2C address,
+	// so that a missing peripheral is detected instead of blocking later
+	bool platformClass::probeI2C(uint8_t address, uint8_t peripheral)
+	{
+		static bool wire = false;
+		bool answer;
+
+		holdAcquisition();
+		if (!wire){
+			Wire.begin();
+			wire = true;
+		}
+		Wire.beginTransmission(address);
+		answer = (Wire.endTransmission() == 0);
+		releaseAcquisition();
+		if (!answer){
+			Serial.print("DEBUG: No answer on I2C address ");
+			Serial.println(address, HEX);
+			platformClass::failed |= peripheral;
+			return false;
+		}
+		platformClass::initialized |= peripheral;
+		return true;
+	}
+
+	//! This function will mask the snapshots of timer TC4 while the foreground
+	// uses the I2C bus or the ADC, which its interrupt uses too. They are
+	// not nested: each one holds a single transaction
+	void platformClass::holdAcquisition(void)
+	{
+#ifdef ARDUINO_ARCH_SAMD
+		if (platformClass::acquiring){
+			NVIC_DisableIRQ(TC4_IRQn);
+		}
+#endif
+	}
+
+	void platformClass::releaseAcquisition(void)
+	{
+#ifdef ARDUINO_ARCH_SAMD
+		if (platformClass::acquiring){
+			NVIC_EnableIRQ(TC4_IRQn);
+		}
+#endif
+	}
+
+	//! This function will prepare the display for visualization
+	void platformClass::clean(void)
+	{
+		display.clearDisplay();
+		display.setTextSize(1);
+		display.setTextColor(WHITE);
+		display.setCursor(0,0);
+	}
+	
+	//!******************************************************************************
+	//!	Name:	initializeSD()							*
+	//!	Description: Initialize the memory card SD				*
+	//!	Param : void								*
+	//!	Returns: int with the success (0) or fail (-1) of the initialization 	*
+	//!	Example: platform.initializeSD();					*
+	//!******************************************************************************
+	int  platformClass::initializeSD(void)
+	{
+		digitalWrite(RFM95_CS, HIGH);      //Disable LORA
+		digitalWrite(CS_SD, LOW);	   //Enable SD
+		if (!SD.begin(CS_SD)){
+			Serial.println("DEBUG: SD initialization failed!");
+			platformClass::initialized &= ~PERIPHERAL_SD;
+			platformClass::failed |= PERIPHERAL_SD;
+			return -1;
+		}
+		platformClass::initialized |= PERIPHERAL_SD;
+		Serial.println("DEBUG: SD Initialized!");
+		return 0;
+	}
+
+	
+	
+//***************************************************************
+// Interrupt handlers						*
+//***************************************************************
+
+#ifdef ARDUINO_ARCH_SAMD
+	//! Timer TC3: background reading of the anenometer
+	void TC3_Handler(void)
+	{
+		TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+		anenometer.add(analogRead(ANENOMETER));
+	}
+
+	//! Timer TC4: snapshot of the fast channels every acquirePeriod ms
+	void TC4_Handler(void)
+	{
+		queuedSample q;
+		uint32_t now = millis();
+
+		TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+		if (now - acquireLast < acquirePeriod){
+			return;
+		}
+		// Keep the pace of the period, unless the foreground held the timer longer
+		acquireLast = (now - acquireLast < 2 * (uint32_t)acquirePeriod) ? acquireLast + acquirePeriod : now;
+		q.time = now;
+		q.sequence = acquireTaken++;
+		q.valid = 0;
+		q.wind = 0;
+		q.loadCurrent = q.loadPower = NAN;
+		q.batteryCurrent = q.batteryPower = NAN;
+		if (acquireSources & SAMPLE_LOAD){
+			q.loadCurrent = ina1.getCurrent_mA();
+			q.loadPower = ina1.getPower_mW();
+			q.valid |= SAMPLE_LOAD;
+		}
+		if (acquireSources & SAMPLE_BATTERY){
+			q.batteryCurrent = ina2.getCurrent_mA();
+			q.batteryPower = ina2.getPower_mW();
+			q.valid |= SAMPLE_BATTERY;
+		}
+		if (acquireSources & SAMPLE_WIND){
+			q.wind = analogRead(ANENOMETER);
+			q.valid |= SAMPLE_WIND;
+		}
+		snapshots.push(q);
+	}
+#endif
+
+//***************************************************************
+// Preinstantiate Objects					*
+//***************************************************************
+
+	platformClass platform = platformClass();
+
+
+
+
+
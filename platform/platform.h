@@ -18,16 +18,134 @@
 #include "RTClib.h"
 #include <SPI.h>
 #include <RH_RF95.h>
+#include "frame.h"
+#include "adr.h"
+#include "trace.h"
+#include "sampleQueue.h"
+
+// Sources of a sample cycle, also used as validity flags of a Sample
+#define	SAMPLE_TIME		0x0001	// RTC timestamp
+#define	SAMPLE_PANEL		0x0002	// panel current and power (ina0)
+#define	SAMPLE_LOAD		0x0004	// load current and power (ina1)
+#define	SAMPLE_BATTERY		0x0008	// battery current and power (ina2)
+#define	SAMPLE_WIND		0x0010	// anenometer
+#define	SAMPLE_NODE		0x0020	// temperature, humidity and battery voltage asked on Serial1
+#define	SAMPLE_CLIMATE		0x0040	// temperature and humidity of the local SHT1x, not with SAMPLE_WIND (pin A1)
+#define	SAMPLE_TESTBED		(SAMPLE_TIME|SAMPLE_PANEL|SAMPLE_LOAD|SAMPLE_BATTERY|SAMPLE_WIND|SAMPLE_NODE)
+
+// Where drainSamples() puts the snapshots of the background acquisition
+#define	DRAIN_SD		0x01	// every snapshot, with writeSample() and one flush()
+#define	DRAIN_LORA		0x02	// the last one, with sendSample()
+
+// Peripherals of the platform, as flags for initialize() and getDegraded()
+#define	PERIPHERAL_SD		0x01
+#define	PERIPHERAL_RTC		0x02
+#define	PERIPHERAL_LORA		0x04
+#define	PERIPHERAL_DISPLAY	0x08
+#define	PERIPHERAL_INA0		0x10
+#define	PERIPHERAL_INA1		0x20
+#define	PERIPHERAL_INA2		0x40
+#define	PERIPHERAL_ALL		0x7F
+
+//! Breakdown of the boot time (ms)
+struct BootTime {
+	uint16_t sd;			// initialization of each peripheral,
+	uint16_t rtc;			// whether at initialize() or on first use
+	uint16_t lora;
+	uint16_t display;
+	uint16_t ina;			// the three INA219
+	uint32_t ready;			// since reset to the end of initialize()
+	uint32_t firstSample;		// since reset to the end of the first sample()
+	uint16_t recovery;		// finding the end of the log at the last open() to write
+};
+
+//! Statistics of the wind since the previous getWindStats()
+struct WindStats {
+	uint32_t samples;		// readings of the anenometer
+	float average;			// m/s
+	float minimum;			// m/s
+	float maximum;			// m/s, highest reading
+	float gust;			// m/s, highest mean over 3 s, NAN if shorter
+	float deviation;		// m/s, standard deviation
+	float turbulence;		// deviation / average
+};
+
+//! Snapshots of the background acquisition, see startAcquisition()
+struct QueueStats {
+	uint32_t taken;			// snapshots taken by the timer
+	uint32_t overflows;		// snapshots dropped because the queue was full
+	uint16_t queued;		// snapshots waiting to be drained
+	uint16_t highWater;		// most snapshots queued at once
+	uint16_t capacity;		// QUEUE_SAMPLES
+};
+
+//! Frames sent with an ADR setting, see getLinkStats()
+struct LinkStats {
+	uint8_t spreadingFactor;
+	uint32_t bandwidth;		// Hz
+	int8_t power;			// dBm
+	uint16_t sent;			// frames
+	uint16_t delivered;		// frames acknowledged by the gateway
+	uint32_t airtime;		// ms
+	float energyPerByte;		// mJ of the transmissions per byte delivered, NAN if none
+	float deliveryRatio;		// delivered / sent, NAN if none sent
+};
+
+// Status of the climate (SHT1x) measurements
+#define	CLIMATE_OK		0	// temperature and humidity are ready
+#define	CLIMATE_BUSY		1	// the sensor is still converting
+#define	CLIMATE_NO_ACK		-1	// the sensor did not acknowledge the command
+#define	CLIMATE_TIMEOUT		-2	// the conversion did not finish in time
+
+// sendLoRa() and sendSample() with TDMA before the slot of the node
+#define	LORA_WAIT		1	// kept: sent by a later call in the slot, see sendPending()
+
+//! Record collected by one sample cycle
+struct Sample {
+	uint32_t time;			// unix time of the sample (s)
+	uint32_t cycle;			// duration of the cycle (ms)
+	uint16_t valid;			// SAMPLE_* flags of the fields read
+	float panelCurrent;		// mA
+	float panelPower;		// mW
+	float loadCurrent;		// mA
+	float loadPower;		// mW
+	float batteryCurrent;		// mA
+	float batteryPower;		// mW
+	float temperature;		// C
+	float humidity;			// %
+	float batteryVoltage;		// V
+	float windSpeed;		// m/s
+};
 
 // Library interface description
 class platformClass {
 	// Singleton instance of the SD
 	static File file;
-	static bool initializedSD;
+	// The file is a log open to write (blocklog.h)
+	static bool logging;
 	// Singleton instance of the rtc
 	static RTC_PCF8523 rtc;
-	static bool initializedRTC;
-	static bool initializedRFMLoRa;
+	// PERIPHERAL_* flags of the peripherals ready and of those that failed
+	static uint8_t initialized;
+	static uint8_t failed;
+	static BootTime boot;
+	// Identifier, reset epoch and frame counter of the node for the telemetry frames
+	static uint16_t nodeId;
+	static uint16_t epoch;
+	static uint16_t sequence;
+	static bool capturingWind;
+	static bool acquiring;
+	static bool tdmaEnabled;
+	// Adaptive data rate: setting of the radio and, on the gateway, the slot followed
+	static bool adrEnabled;
+	static uint8_t radioRate;
+	static uint8_t radioLevel;
+	static uint16_t adrSlot;
+	static bool adrHeard;
+	// State of the climate measurement in progress
+	static uint8_t climateState;
+	static unsigned long climateStarted;
+	static float climateTemperature;
 	public: 
 	//***************************************************************
 	// Constructor of the class					*
@@ -44,6 +162,24 @@ class platformClass {
 		\param void
 		\return int : The library version. 
 		*/	int version(void);
+
+		//! Initializes the given peripherals now, the others on first use
+		/*!
+		\param uint8_t : PERIPHERAL_* flags
+		\return int with the success (0) or fail (-1) of any initialization
+		*/	int initialize(uint8_t peripherals = 0);
+
+		//! Returns the peripherals that failed to initialize
+		/*!
+		\param void
+		\return uint8_t : PERIPHERAL_* flags of the peripherals not available
+		*/	uint8_t getDegraded(void);
+
+		//! Returns the breakdown of the boot time
+		/*!
+		\param void
+		\return BootTime : time spent initializing each peripheral
+		*/	BootTime getBootTime(void);
 		
 		//! Initializes the Real Time Clock (RTC)
 		/*!
@@ -66,7 +202,7 @@ class platformClass {
 		//! Send data through Lora module
 		/*!
 		\param String with the data
-		\return int with the success (0) or fail (-1) of the initialization
+		\return int with the success (0), LORA_WAIT or fail (-1) of the sending
 		*/	int sendLoRa(String);
 
 		//! Receive data through Lora module
@@ -75,6 +211,75 @@ class platformClass {
 		\return String with the data received
 		*/	String receiveLoRa(void);
 
+		//! Set the identifier of the node in the telemetry frames
+		/*!
+		\param uint16_t : node identifier
+		\return void
+		*/	void setNodeId(uint16_t);
+
+		//! Send a sample as a telemetry frame through Lora module
+		/*!
+		\param Sample : record to send
+		\return int with the success (0), LORA_WAIT or fail (-1) of the sending
+		*/	int sendSample(const Sample &);
+
+		//! Send the packet kept out of the time slot, if the slot is on
+		/*!
+		\param void
+		\return int with the success (0, also if none was kept), LORA_WAIT or fail (-1) of the sending
+		*/	int sendPending(void);
+
+		//! Copy a packet received through Lora module to Serial (gateway)
+		/*!
+		\param void
+		\return int with the bytes forwarded, 0 if none or -1 if fail
+		*/	int forwardLoRa(void);
+
+		//! Transmit only in the time slot of the node
+		/*!
+		\param uint16_t : slots per frame (>= nodes)
+		\param uint16_t : length of a slot (ms)
+		\param uint16_t : guard time at both ends of the slot (ms)
+		\return int with the success (0) or fail (-1) of the sync with the RTC
+		*/	int enableTDMA(uint16_t slots, uint16_t slotLength, uint16_t guard);
+
+		//! Transmit at any time
+		/*!
+		\param void
+		\return void
+		*/	void disableTDMA(void);
+
+		//! Time until sendSample() can send in the slot of the node
+		/*!
+		\param void
+		\return uint32_t with the ms, 0 if now or without TDMA
+		*/	uint32_t getSlotWait(void);
+
+		//! Broadcast the network time to the nodes (gateway)
+		/*!
+		\param void
+		\return int with the success (0) or fail (-1) of the sending
+		*/	int sendBeacon(void);
+
+		//! Adapt the modem setting and TX power of sendSample() (node) or acknowledge the frames with the setting for each node (gateway)
+		/*!
+		\param void
+		\return void
+		*/	void enableADR(void);
+
+		//! Send at the default setting and the highest power
+		/*!
+		\param void
+		\return void
+		*/	void disableADR(void);
+
+		//! Returns the frames sent with an ADR setting
+		/*!
+		\param uint8_t : setting, 0 (SF12) to ADR_RATES - 1
+		\param uint8_t : TX power level, 0 (ADR_MAX_POWER) to ADR_LEVELS - 1
+		\return LinkStats : airtime, energy per byte delivered and delivery ratio
+		*/	LinkStats getLinkStats(uint8_t rate, uint8_t level);
+
 		//! Returns the temperature
 		/*!
 		\param void
@@ -151,9 +356,52 @@ class platformClass {
 		\param void
 		\return float : The anenometer value 
 		*/	float getSpeedOfWind( void );
+
+		//! Start sampling the anenometer in the background (timer TC3)
+		/*!
+		\param void
+		\return int with the success (0) or fail (-1) if not supported
+		*/	int startWindCapture( void );
+
+		//! Stop sampling the anenometer in the background
+		/*!
+		\param void
+		\return void
+		*/	void stopWindCapture( void );
+
+		//! Returns the statistics of the wind since the previous call
+		/*!
+		\param WindStats : statistics
+		\return int: 0 if success and -1 if there are no readings
+		*/	int getWindStats( WindStats & );
+
+		//! Take snapshots of the load, the battery and the anenometer in the background (timer TC4)
+		/*!
+		\param uint16_t : ms between snapshots
+		\param uint16_t : SAMPLE_LOAD, SAMPLE_BATTERY and SAMPLE_WIND flags of the channels
+		\return int with the success (0) or fail (-1) if not supported
+		*/	int startAcquisition( uint16_t period, uint16_t sources = SAMPLE_LOAD|SAMPLE_BATTERY|SAMPLE_WIND );
+
+		//! Stop taking snapshots; those queued can still be drained
+		/*!
+		\param void
+		\return void
+		*/	void stopAcquisition( void );
+
+		//! Write and send the snapshots queued by the background acquisition
+		/*!
+		\param uint8_t : DRAIN_* flags
+		\return int with the snapshots drained or -1 if writing or sending failed
+		*/	int drainSamples( uint8_t outputs );
+
+		//! Returns the counters of the queue of the background acquisition
+		/*!
+		\param void
+		\return QueueStats : counters
+		*/	QueueStats getQueueStats( void );
 		
 	
-		//! Open a file to read/write on SD
+		//! Open a file to read/write on SD. To write, it is a crash-consistent log that resumes after its last valid block
 		/*!
 		\param String : filename
 		\param mode : open mode (READ|WRITE)
@@ -166,17 +414,47 @@ class platformClass {
 		\return void
 		*/	static void close();
 	
-		//! Store data in SD
+		//! Store a line in the log on SD, on the card when its block is full or on flush()
 		/*!
 		\param String : data to be stored
-		\return int: number of bytes written 
+		\return int: 0 if success and -1 if fail
 		*/	static int writeline( String );
+
+		//! Write the lines of the log kept in RAM to SD
+		/*!
+		\param void
+		\return int: 0 if success and -1 if fail
+		*/	static int flush( void );
 		
 		//! Read data from SD	
 		/*!
 		\param File : file descriptor
 		\return string: number of bytes written . 
 		*/	String readline();
+
+		//! Record the readings, timing and radio events in a trace on SD (trace.h)
+		/*!
+		\param String : filename, resumed if it holds a trace
+		\return int: 0 if success and -1 if fail
+		*/	int startTrace( String );
+
+		//! Write the records of the trace kept in RAM to SD
+		/*!
+		\param void
+		\return int: 0 if success and -1 if fail
+		*/	int flushTrace( void );
+
+		//! Stop recording the trace
+		/*!
+		\param void
+		\return void
+		*/	void stopTrace( void );
+
+		//! Give the readings and events to a backend instead, e.g. the replay of a trace on a host
+		/*!
+		\param traceBackend : backend, NULL for none
+		\return void
+		*/	void setTracer( traceBackend * );
 	
 		//! Activate debug by means of display
 		/*!
@@ -202,6 +480,26 @@ class platformClass {
 		
 		//! Read Humidity Sensor
 		float readHumidity();
+
+		//! Read temperature and humidity with one conversion each
+		/*!
+		\param float : temperature (C)
+		\param float : relative humidity (%)
+		\return int: CLIMATE_OK or the CLIMATE_* error
+		*/	int readClimate(float &, float &);
+
+		//! Start a climate measurement without waiting for it
+		/*!
+		\param void
+		\return int: CLIMATE_OK if started or the CLIMATE_* error
+		*/	int startClimate(void);
+
+		//! Advance the climate measurement (started if there is none)
+		/*!
+		\param float : temperature (C), set when ready
+		\param float : relative humidity (%), set when ready
+		\return int: CLIMATE_OK when ready, CLIMATE_BUSY or the CLIMATE_* error
+		*/	int pollClimate(float &, float &);
 		
 		//! Read battery voltage sensor
 		float readBatteryVoltage();
@@ -215,6 +513,19 @@ class platformClass {
 		/*
 		\return String with the date and time */
 		
+		//! Collect a sample overlapping the slow operations
+		/*!
+		\param Sample : record to fill
+		\param uint16_t : SAMPLE_* sources to read, not SAMPLE_CLIMATE with SAMPLE_WIND
+		\return int: 0 if every source was read and -1 if not
+		*/	int sample(Sample &, uint16_t sources = SAMPLE_TESTBED);
+
+		//! Store a sample in SD as a line of text
+		/*!
+		\param Sample : record to store
+		\return int: 0 if success and -1 if fail
+		*/	static int writeSample(const Sample &);
+		
 		
 		
 	private:
@@ -225,6 +536,98 @@ class platformClass {
 	
 		//! Change the state of the relay
 		void relay(int status);
+
+		//! Initialize a peripheral if it was not tried yet
+		/*!
+		\param uint8_t : PERIPHERAL_* flag
+		\return bool: true if the peripheral is ready
+		*/	static bool ensure(uint8_t);
+
+		//! Check that a device answers on the I2C bus
+		/*!
+		\param uint8_t : I2C address
+		\param uint8_t : PERIPHERAL_* flag to update
+		\return bool: true if present
+		*/	static bool probeI2C(uint8_t, uint8_t);
+
+		//! Mask the background acquisition while the I2C bus or the ADC are used
+		static void holdAcquisition(void);
+		static void releaseAcquisition(void);
+
+		//! Read a line from Serial1 without blocking
+		/*!
+		\param String : line being received
+		\return bool: true when the line is complete
+		*/	bool pollSerial1(String &);
+
+		//! Returns the milliseconds since reset without wrapping
+		uint64_t localTime(void);
+
+		//! Give a reading to the tracer, if any, and return the value to use
+		static float trace(uint8_t, float);
+
+		//! Give a packet sent (true) or received at a millis() to the tracer, if any
+		static void traceRadio(bool, uint32_t, const uint8_t *, uint8_t);
+
+		//! Returns the ms on air of a packet of the given bytes, and the header, with the current setting
+		static uint32_t airtime(uint8_t);
+
+		//! Returns the ms until a transmission of the given ms fits in the time slot, 0 if now
+		uint32_t slotWait(uint32_t);
+
+		//! Returns the ms of a telemetry frame and its acknowledgement, if any, in the slot
+		static uint32_t frameSlot(void);
+
+		//! Send a packet now, or return LORA_WAIT out of the time slot
+		int transmitText(String);
+		int transmitSample(const Sample &);
+
+		//! Tell that the packet kept out of the slot is replaced
+		static void keepPending(void);
+
+		//! Change the modem setting and TX power level (adr.h) if they differ
+		static void tune(uint8_t, uint8_t);
+
+		//! Wait for the acknowledgement of a frame and take its setting (node)
+		/*!
+		\param uint16_t : sequence of the frame
+		\return bool: true if it was acknowledged
+		*/	bool waitAck(uint16_t);
+
+		//! Acknowledge a telemetry frame with the setting for the next ones (gateway)
+		void acknowledge(const uint8_t *, uint8_t);
+
+		//! Listen with the setting of the node whose slot is going on (gateway)
+		void followSlot(void);
+
+		//! Returns the ADR of a node (slot with TDMA), NULL if there is no room
+		static adrController *adrNode(uint16_t);
+
+		//! Correct the network time with a beacon
+		/*!
+		\param uint8_t* : packet received
+		\param uint8_t : bytes
+		\return bool: true if the packet was a beacon
+		*/	bool syncBeacon(const uint8_t *, uint8_t);
+
+		//! Send a command to the SHT1x
+		/*!
+		\param uint8_t : command
+		\return int: CLIMATE_OK or CLIMATE_NO_ACK
+		*/	int commandSHT1x(uint8_t);
+
+		//! Check if the SHT1x finished the conversion
+		bool readySHT1x(void);
+
+		//! Read the result of the SHT1x conversion (CRC is skipped)
+		uint16_t readSHT1x(void);
+
+		//! Send a command to the SHT1x and wait for the result
+		/*!
+		\param uint8_t : command
+		\param uint16_t : result
+		\return int: CLIMATE_OK or the CLIMATE_* error
+		*/	int measureSHT1x(uint8_t, uint16_t &);
 		
 		//! Prepare the screen to display data
 		/*!
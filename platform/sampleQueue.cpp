@@ -0,0 +1,66 @@
+/*
+ *  Queue of the snapshots taken in the background
+ *
+ *  Version 1.0
+ */
+
+#include "sampleQueue.h"
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	sampleQueue::sampleQueue(void) : head(0), tail(0), overflows(0), highWater(0)
+	{
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	//! This function will copy the record in the next free slot and then
+	// publish it. It runs in the timer interrupt
+	bool sampleQueue::push(const queuedSample &s)
+	{
+		uint32_t t = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+		uint32_t used = t - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+		if (used >= QUEUE_SAMPLES){
+			__atomic_store_n(&overflows, overflows + 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		ring[t & (QUEUE_SAMPLES - 1)] = s;
+		__atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+		if (used + 1 > highWater){
+			__atomic_store_n(&highWater, (uint16_t)(used + 1), __ATOMIC_RELAXED);
+		}
+		return true;
+	}
+
+	//! This function will copy the oldest record and then free its slot
+	bool sampleQueue::pop(queuedSample &s)
+	{
+		uint32_t h = __atomic_load_n(&head, __ATOMIC_RELAXED);
+
+		if (h == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)){
+			return false;
+		}
+		s = ring[h & (QUEUE_SAMPLES - 1)];
+		__atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	uint16_t sampleQueue::size(void)
+	{
+		return __atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_RELAXED);
+	}
+
+	uint32_t sampleQueue::getOverflows(void)
+	{
+		return __atomic_load_n(&overflows, __ATOMIC_RELAXED);
+	}
+
+	uint16_t sampleQueue::getHighWater(void)
+	{
+		return __atomic_load_n(&highWater, __ATOMIC_RELAXED);
+	}
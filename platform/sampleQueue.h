@@ -0,0 +1,67 @@
+/*
+ *  Queue of the snapshots taken in the background
+ *
+ *  A timer interrupt takes snapshots of the fast channels and push()es
+ *  them; the loop pop()s them when it has time to write or send them,
+ *  so a slow SD write or a long transmission does not delay the next
+ *  snapshot. The ring holds QUEUE_SAMPLES records of a fixed size.
+ *
+ *  The interrupt only writes tail and the loop only writes head, so no
+ *  lock is needed and the interrupt is never masked to take a record:
+ *  each side publishes its index with release semantics and reads the
+ *  other one with acquire semantics. The __atomic builtins of GCC turn
+ *  them into word accesses with barriers on the Cortex-M0+, and the
+ *  class runs as well between two threads of a host. A snapshot taken
+ *  with the queue full is dropped and counted, since only the loop may
+ *  free a slot.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef sampleQueue_h
+#define sampleQueue_h
+
+#include <stdint.h>
+
+#define	QUEUE_SAMPLES	64	// records of the ring, power of two
+
+//! Snapshot of the fast channels
+struct queuedSample {
+	uint32_t time;			// millis() of the snapshot
+	uint32_t sequence;		// snapshots taken before, dropped ones included
+	uint16_t valid;			// flags of the channels read (SAMPLE_* of platform.h)
+	uint16_t wind;			// ADC reading of the anenometer
+	float loadCurrent;		// mA
+	float loadPower;		// mW
+	float batteryCurrent;		// mA
+	float batteryPower;		// mW
+};
+
+class sampleQueue {
+	queuedSample ring[QUEUE_SAMPLES];
+	uint32_t head;			// records taken out (loop)
+	uint32_t tail;			// records put in (interrupt)
+	uint32_t overflows;		// records dropped with the queue full (interrupt)
+	uint16_t highWater;		// most records queued at once (interrupt)
+	public:
+		sampleQueue(void);
+
+		//! Adds a record (interrupt). Returns false if the queue is full
+		bool push(const queuedSample &s);
+
+		//! Takes the oldest record (loop). Returns false if the queue is empty
+		bool pop(queuedSample &s);
+
+		//! Returns the records queued
+		uint16_t size(void);
+
+		//! Returns the records dropped because the queue was full
+		uint32_t getOverflows(void);
+
+		//! Returns the most records queued at once
+		uint16_t getHighWater(void);
+};
+
+#endif
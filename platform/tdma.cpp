@@ -0,0 +1,77 @@
+/*
+ *  Time slotted (TDMA) uplink of the nodes
+ *
+ *  Version 1.0
+ */
+
+#include "tdma.h"
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	tdmaScheduler::tdmaScheduler(void) : slots(1), slot(0), slotLength(1000), guard(0), offset(0)
+	{
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	void tdmaScheduler::configure(uint16_t node, uint16_t slots, uint32_t slotLength, uint32_t guard)
+	{
+		this->slots = slots ? slots : 1;
+		this->slot = node % this->slots;
+		this->slotLength = slotLength;
+		this->guard = guard;
+	}
+
+	uint16_t tdmaScheduler::getSlot(void)
+	{
+		return slot;
+	}
+
+	uint16_t tdmaScheduler::slotOf(uint16_t node)
+	{
+		return node % slots;
+	}
+
+	uint16_t tdmaScheduler::currentSlot(uint64_t local)
+	{
+		return (networkTime(local) / slotLength) % slots;
+	}
+
+	//!******************************************************************************
+	//!	Name:	wait()								*
+	//!	Description: Returns how long to wait so that a transmission starts	*
+	//!	inside the slot of the node and ends before its guard. 0 if it can	*
+	//!	start now. If the slot is too short for the packet it waits for the	*
+	//!	beginning of the slot anyway.						*
+	//!	Param : local clock (ms) and airtime of the packet (ms)		*
+	//!	Returns: uint32_t with the ms to wait					*
+	//!	Example: delay(tdma.wait(now, 120));					*
+	//!******************************************************************************
+	uint32_t tdmaScheduler::wait(uint64_t local, uint32_t airtime)
+	{
+		uint64_t period = (uint64_t)slots * slotLength;
+		uint64_t position = networkTime(local) % period;
+		uint64_t start = (uint64_t)slot * slotLength + guard;
+		uint64_t end = (uint64_t)(slot + 1) * slotLength;
+
+		// Latest start that still ends before the guard
+		end = (end > start + guard + airtime) ? end - guard - airtime : start;
+		if ((position >= start) and (position <= end)){
+			return 0;
+		}
+		return (start + period - position) % period;
+	}
+
+	void tdmaScheduler::correct(uint64_t network, uint64_t local)
+	{
+		offset = (int64_t)(network - local);
+	}
+
+	uint64_t tdmaScheduler::networkTime(uint64_t local)
+	{
+		return local + offset;
+	}
@@ -0,0 +1,56 @@
+/*
+ *  Time slotted (TDMA) uplink of the nodes
+ *
+ *  Time is divided in frames of slots slots of slotLength ms, counted
+ *  from the unix epoch, and each node transmits only in slot
+ *  node % slots. A transmission must start guard ms after the slot
+ *  begins and end guard ms before it finishes, so that clocks apart
+ *  less than the guard do not collide. Nodes should have distinct
+ *  slots, i.e. slots >= nodes with consecutive identifiers.
+ *
+ *  The network time is the local clock plus an offset, corrected
+ *  with the beacons of the gateway. The class does not use the
+ *  hardware, so it can be simulated on a host (tools/radio).
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef tdmaScheduler_h
+#define tdmaScheduler_h
+
+#include <stdint.h>
+
+class tdmaScheduler {
+	uint16_t slots;			// slots per frame
+	uint16_t slot;			// slot of the node
+	uint32_t slotLength;		// ms
+	uint32_t guard;			// ms at both ends of the slot
+	int64_t offset;			// ms from the local clock to the network time
+	public:
+		tdmaScheduler(void);
+
+		//! Sets the slot of the node and the length of the slots (ms)
+		void configure(uint16_t node, uint16_t slots, uint32_t slotLength, uint32_t guard);
+
+		//! Returns the slot of the node
+		uint16_t getSlot(void);
+
+		//! Returns the slot of another node
+		uint16_t slotOf(uint16_t node);
+
+		//! Returns the slot going on at a moment of the local clock (ms)
+		uint16_t currentSlot(uint64_t local);
+
+		//! Returns the ms of the local clock until a transmission of airtime ms can start
+		uint32_t wait(uint64_t local, uint32_t airtime);
+
+		//! Sets the network time (ms) at a moment of the local clock (ms)
+		void correct(uint64_t network, uint64_t local);
+
+		//! Returns the network time (ms) at a moment of the local clock (ms)
+		uint64_t networkTime(uint64_t local);
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ *  Trace of the readings, timing and radio events of a node
+ *
+ *  Version 1.0
+ */
+
+#include <string.h>
+#include "trace.h"
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	traceWriter::traceWriter(void) : used(0), last(0)
+	{
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	bool traceWriter::start(uint32_t time, uint32_t unixtime)
+	{
+		uint8_t payload[9];
+
+		payload[0] = TRACE_VERSION;
+		memcpy(payload + 1, &time, sizeof(time));
+		memcpy(payload + 5, &unixtime, sizeof(unixtime));
+		return event(TRACE_START, time, payload, sizeof(payload));
+	}
+
+	bool traceWriter::reading(uint8_t kind, uint32_t time, float value)
+	{
+		if (!header(kind, time, sizeof(value))){
+			return false;
+		}
+		memcpy(buffer + used, &value, sizeof(value));
+		used += sizeof(value);
+		return true;
+	}
+
+	bool traceWriter::event(uint8_t kind, uint32_t time, const void *data, uint8_t length)
+	{
+		if (!header(kind, time, 1 + length)){
+			return false;
+		}
+		buffer[used++] = length;
+		memcpy(buffer + used, data, length);
+		used += length;
+		return true;
+	}
+
+	const uint8_t *traceWriter::data(void)
+	{
+		return buffer;
+	}
+
+	uint16_t traceWriter::size(void)
+	{
+		return used;
+	}
+
+	void traceWriter::clear(void)
+	{
+		used = 0;
+	}
+
+//***************************************************************
+// Private Methods						*
+//***************************************************************
+
+	bool traceWriter::header(uint8_t kind, uint32_t time, uint16_t payload)
+	{
+		uint8_t varint[5];
+		uint8_t n = 0;
+		// A session restarts the time: its record holds the absolute millis().
+		// Events traced late go back, and take 5 bytes
+		uint32_t delta = (kind == TRACE_START) ? 0 : time - last;
+
+		do {
+			varint[n++] = (delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0);
+			delta >>= 7;
+		} while (delta);
+		if ((size_t)used + 1 + n + payload > LOG_PAYLOAD){
+			return false;
+		}
+		buffer[used++] = kind;
+		memcpy(buffer + used, varint, n);
+		used += n;
+		last = time;
+		return true;
+	}
+
+bool traceDecode(const uint8_t *&p, const uint8_t *end, uint32_t &time, traceRecord &record)
+{
+	uint32_t delta = 0;
+	uint8_t shift = 0;
+
+	if (p >= end){
+		return false;
+	}
+	record.kind = *p++;
+	do {
+		if ((p >= end) or (shift > 28)){
+			return false;
+		}
+		delta |= (uint32_t)(*p & 0x7F) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+	time += delta;
+	record.value = 0;
+	record.length = 0;
+	record.data = NULL;
+	if (record.kind < TRACE_READINGS){
+		if (end - p < (int)sizeof(record.value)){
+			return false;
+		}
+		memcpy(&record.value, p, sizeof(record.value));
+		p += sizeof(record.value);
+	}else{
+		if ((p >= end) or (end - p - 1 < *p)){
+			return false;
+		}
+		record.length = *p++;
+		record.data = p;
+		p += record.length;
+	}
+	// The start of a session holds its absolute time
+	if ((record.kind == TRACE_START) and (record.length >= 5)){
+		memcpy(&time, record.data + 1, sizeof(time));
+	}
+	record.time = time;
+	return true;
+}
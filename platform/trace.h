@@ -0,0 +1,106 @@
+/*
+ *  Trace of the readings, timing and radio events of a node
+ *
+ *  While tracing, every value read from the hardware and every packet
+ *  sent or received goes through a traceBackend. On the node it is
+ *  recorded in a trace on the SD (platform.startTrace()); on a host, the
+ *  replay (tools/replay) gives back the recorded values instead, so the
+ *  same platformClass code and sketches run over a deployment day as
+ *  fast as the CPU allows.
+ *
+ *  A record is the kind, the ms since the previous record as a varint
+ *  and its payload: a float for readings, the length and the bytes for
+ *  events. Records are packed in blocks of a block log (blocklog.h),
+ *  never across two, so a power loss loses at most the block being
+ *  filled. Each boot starts a session with TRACE_START, which holds
+ *  the millis() and the unix time (0 without RTC) of its first record.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef trace_h
+#define trace_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "blocklog.h"
+
+#define	TRACE_VERSION	1
+
+// Kinds of record. Readings (float payload)
+#define	TRACE_PANEL_CURRENT	1	// mA, ina0
+#define	TRACE_PANEL_POWER	2	// mW, ina0
+#define	TRACE_LOAD_CURRENT	3	// mA, ina1
+#define	TRACE_LOAD_POWER	4	// mW, ina1
+#define	TRACE_BATTERY_CURRENT	5	// mA, ina2
+#define	TRACE_BATTERY_POWER	6	// mW, ina2
+#define	TRACE_TEMPERATURE	7	// C, answered by the node on Serial1
+#define	TRACE_HUMIDITY		8	// %, answered by the node on Serial1
+#define	TRACE_NODE_BATTERY	9	// V, answered by the node on Serial1
+#define	TRACE_BATTERY_VOLTAGE	10	// V, ADC of the board
+#define	TRACE_WIND		11	// m/s, reading or mean of the capture
+#define	TRACE_SHT_TEMPERATURE	12	// raw, SHT1x
+#define	TRACE_SHT_HUMIDITY	13	// raw, SHT1x
+#define	TRACE_READINGS		14	// kinds below are events
+// Events (length and bytes)
+#define	TRACE_START		32	// version, millis() and unix time, 9 bytes
+#define	TRACE_SEND		33	// setting (adr.h), level and bytes of a packet sent at its start, 3 bytes
+#define	TRACE_RECEIVE		34	// RSSI (int16), SNR (int8) and the packet, when it was received
+#define	TRACE_SAMPLE		35	// valid flags (uint16) and cycle ms (uint32) of sample()
+
+//! Record of a trace
+struct traceRecord {
+	uint8_t kind;
+	uint32_t time;			// millis() of the node
+	float value;			// readings
+	uint8_t length;			// events
+	const uint8_t *data;
+};
+
+//! Where the readings and events go while tracing
+class traceBackend {
+	public:
+		virtual ~traceBackend(void) {}
+
+		//! A session starts at the unix time (0 if unknown)
+		virtual void start(uint32_t unixtime) = 0;
+
+		//! A value read from the hardware now, returns the value to use
+		virtual float reading(uint8_t kind, float value) = 0;
+
+		//! An event of the radio or of the sample cycle, at a millis() that
+		// may be past: a packet is traced once the exchange ended
+		virtual void event(uint8_t kind, uint32_t time, const void *data, uint8_t length) = 0;
+};
+
+//! Packs records in the payload of a block
+class traceWriter {
+	uint8_t buffer[LOG_PAYLOAD];
+	uint16_t used;
+	uint32_t last;			// time of the previous record
+
+	//! Appends the header of a record if it and the payload fit
+	bool header(uint8_t kind, uint32_t time, uint16_t payload);
+	public:
+		traceWriter(void);
+
+		//! Appends a record, false if the block is full
+		bool start(uint32_t time, uint32_t unixtime);
+		bool reading(uint8_t kind, uint32_t time, float value);
+		bool event(uint8_t kind, uint32_t time, const void *data, uint8_t length);
+
+		//! Records packed since the last clear()
+		const uint8_t *data(void);
+		uint16_t size(void);
+
+		//! Empties the block; the time of the next record stays relative to the last one
+		void clear(void);
+};
+
+//! Decodes the record at p, before end, and moves p past it. The time of
+// the previous record is given in time and updated. Returns false at the end
+bool traceDecode(const uint8_t *&p, const uint8_t *end, uint32_t &time, traceRecord &record);
+
+#endif
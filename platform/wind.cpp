@@ -0,0 +1,77 @@
+/*
+ *  Background capture of the anenometer
+ *
+ *  Version 1.0
+ */
+
+#include "wind.h"
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	windCapture::windCapture(uint8_t gustSamples) : head(0), window(0)
+	{
+		totals.count = 0;
+		totals.sum = 0;
+		totals.squares = 0;
+		totals.low = 0xFFFF;
+		totals.high = 0;
+		totals.gust = 0;
+		totals.gustSamples = (gustSamples < WIND_BUFFER) ? gustSamples : WIND_BUFFER - 1;
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	//! This function will store a reading, slide the gust window over it
+	// and accumulate it. It runs in the timer interrupt
+	void windCapture::add(uint16_t reading)
+	{
+		uint32_t n = head;
+
+		window += reading;
+		if (n >= totals.gustSamples){
+			window -= ring[(n - totals.gustSamples) & (WIND_BUFFER - 1)];
+		}
+		ring[n & (WIND_BUFFER - 1)] = reading;
+		head = n + 1;
+		if ((n + 1 >= totals.gustSamples) and (window > totals.gust)){
+			totals.gust = window;
+		}
+		totals.count++;
+		totals.sum += reading;
+		totals.squares += (uint32_t)reading * reading;
+		if (reading < totals.low){
+			totals.low = reading;
+		}
+		if (reading > totals.high){
+			totals.high = reading;
+		}
+	}
+
+	//! This function will copy the totals and start accumulating again. The
+	// gust window is kept, so a gust may span two calls
+	void windCapture::take(windTotals &t)
+	{
+		t.count = totals.count;
+		t.sum = totals.sum;
+		t.squares = totals.squares;
+		t.low = totals.low;
+		t.high = totals.high;
+		t.gust = totals.gust;
+		t.gustSamples = totals.gustSamples;
+		totals.count = 0;
+		totals.sum = 0;
+		totals.squares = 0;
+		totals.low = 0xFFFF;
+		totals.high = 0;
+		totals.gust = 0;
+	}
+
+	uint16_t windCapture::last(void)
+	{
+		uint32_t n = head;
+		return n ? ring[(n - 1) & (WIND_BUFFER - 1)] : 0;
+	}
@@ -0,0 +1,56 @@
+/*
+ *  Background capture of the anenometer
+ *
+ *  A timer interrupt adds each ADC reading of the anenometer with
+ *  add(). The readings are kept in a ring buffer, used for the moving
+ *  window of the gust, and accumulated until take() returns them and
+ *  starts again. Only integer arithmetic runs in the interrupt; the
+ *  conversion to m/s is done by the caller of take().
+ *
+ *  add() and take() must not run at the same time: call take() with
+ *  the timer interrupt masked. The class does not use the hardware,
+ *  so it can be driven on a host by a simulated timer.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef windCapture_h
+#define windCapture_h
+
+#include <stdint.h>
+
+#define	WIND_BUFFER	64	// readings kept, power of two
+
+//! Readings accumulated since the last take()
+struct windTotals {
+	uint32_t count;			// readings
+	uint32_t sum;			// of the readings
+	uint64_t squares;		// sum of the squared readings
+	uint16_t low;			// lowest reading
+	uint16_t high;			// highest reading
+	uint32_t gust;			// highest sum of gustSamples consecutive readings, 0 if none
+	uint8_t gustSamples;		// readings of the gust window
+};
+
+class windCapture {
+	volatile uint16_t ring[WIND_BUFFER];
+	volatile uint32_t head;		// readings added since the start
+	volatile uint32_t window;	// sum of the last gustSamples readings
+	volatile windTotals totals;
+	public:
+		//! Creates a capture whose gust is the mean of gustSamples readings (< WIND_BUFFER)
+		windCapture(uint8_t gustSamples);
+
+		//! Adds a reading (timer interrupt)
+		void add(uint16_t reading);
+
+		//! Returns the totals since the previous call and resets them
+		void take(windTotals &t);
+
+		//! Returns the last reading
+		uint16_t last(void);
+};
+
+#endif
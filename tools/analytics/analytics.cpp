@@ -0,0 +1,245 @@
+/*
+ *  Batch analytics of the energy harvesting dataset
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "analytics.h"
+
+std::vector<const analyticsKernels*> supportedKernels(void)
+{
+	std::vector<const analyticsKernels*> kernels(1, &scalarKernels);
+
+#if defined(__x86_64__) or defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1")){
+		kernels.push_back(&sseKernels);
+	}
+	if (__builtin_cpu_supports("avx2")){
+		kernels.push_back(&avx2Kernels);
+	}
+#endif
+	return kernels;
+}
+
+const analyticsKernels &selectKernels(void)
+{
+	std::vector<const analyticsKernels*> kernels = supportedKernels();
+	const char *forced = getenv("ANALYTICS_KERNELS");
+
+	if (forced){
+		for (const analyticsKernels *k : kernels){
+			if (strcmp(k->name, forced) == 0){
+				return *k;
+			}
+		}
+	}
+	return *kernels.back();
+}
+
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)> &task)
+{
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> pool;
+
+	if (threads == 0){
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = std::min<size_t>(threads, count);
+	// Tasks are taken one at a time, so a long file does not hold the others
+	for (unsigned t = 0; t < threads; t++){
+		pool.emplace_back([&](){
+			for (size_t i = next++; i < count; i = next++){
+				task(i);
+			}
+		});
+	}
+	for (std::thread &t : pool){
+		t.join();
+	}
+}
+
+//***************************************************************
+// Constructor of the class					*
+//***************************************************************
+
+	analytics::analytics(const analyticsKernels &k) : kernels(k)
+	{
+	}
+
+//***************************************************************
+// Public Methods						*
+//***************************************************************
+
+	const char *analytics::name(void) const
+	{
+		return kernels.name;
+	}
+
+	double analytics::mean(columnSpan<float> x) const
+	{
+		double sum;
+		size_t count;
+
+		kernels.sum(x.data, x.size, sum, count);
+		return count ? sum / count : NAN;
+	}
+
+	void analytics::resample(columnSpan<uint32_t> time, columnSpan<float> x, uint32_t start,
+		uint32_t period, size_t bins, std::vector<float> &out) const
+	{
+		size_t first = std::lower_bound(time.begin(), time.end(), start) - time.begin(), last;
+		double sum;
+		size_t count;
+
+		out.assign(bins, NAN);
+		for (size_t b = 0; (b < bins) and (first < time.size); b++){
+			// Rows of the bin: time sorted, so they follow those of the previous one
+			uint64_t end = (uint64_t)start + (b + 1) * (uint64_t)period;
+			for (last = first; (last < time.size) and (time[last] < end); last++);
+			kernels.sum(x.data + first, last - first, sum, count);
+			if (count){
+				out[b] = sum / count;
+			}
+			first = last;
+		}
+	}
+
+	double analytics::integrate(columnSpan<uint32_t> time, columnSpan<float> x, uint32_t gap) const
+	{
+		return kernels.integrate(time.data, x.data, std::min(time.size, x.size), std::min<uint32_t>(gap, INT32_MAX));
+	}
+
+	double analytics::integrate(columnSpan<uint32_t> time, columnSpan<float> x, columnSpan<float> y,
+		uint32_t gap) const
+	{
+		std::vector<float> product(std::min(x.size, y.size));
+
+		kernels.multiply(x.data, y.data, product.size(), product.data());
+		return integrate(time, columnSpan<float>{product.data(), product.size()}, gap);
+	}
+
+	//!******************************************************************************
+	//!	Name:	rolling()							*
+	//!	Description: Takes the prefix sums of the values, their squares and	*
+	//!	the values present, so each window costs two differences however	*
+	//!	long it is. They are taken over blocks of ROLLING_BLOCK windows, so	*
+	//!	they stay in the cache and small enough for double to keep the		*
+	//!	deviation to float precision. Windows up to ROLLING_BLOCK long read	*
+	//!	one prefix from the start of the block, so their two ends round the	*
+	//!	same way. Longer ones read a prefix over the rows where they start	*
+	//!	and one over those where they end, which begins at the sums of the	*
+	//!	first window and carries on from block to block: the cost of a block	*
+	//!	never grows with w.							*
+	//!	Param : channel, window length, mean and deviation (out)		*
+	//!	Returns: void								*
+	//!	Example: a.rolling(power, 60, mean, deviation);				*
+	//!******************************************************************************
+	void analytics::rolling(columnSpan<float> x, size_t w, std::vector<float> &mean,
+		std::vector<float> &deviation) const
+	{
+		size_t n = x.size, windows, end;
+		std::vector<double> sums(2 * ROLLING_BLOCK + 2), squares(sums.size()), count(sums.size());
+		double s = 0, q = 0, c = 0;
+
+		if ((w == 0) or (w > n)){
+			mean.clear();
+			deviation.clear();
+			return;
+		}
+		windows = n - w + 1;
+		mean.resize(windows);
+		deviation.resize(windows);
+		for (size_t first = 0; (w > ROLLING_BLOCK) and (first < w); first += ROLLING_BLOCK){
+			// Sums of the first window
+			size_t rows = std::min(ROLLING_BLOCK, w - first);
+			sums[0] = s;
+			squares[0] = q;
+			count[0] = c;
+			kernels.prefix(x.data + first, rows, sums.data(), squares.data(), count.data());
+			s = sums[rows];
+			q = squares[rows];
+			c = count[rows];
+		}
+		for (size_t first = 0; first < windows; first += ROLLING_BLOCK){
+			// Windows [first, first + block) read rows [first, first + block + w - 1)
+			size_t block = std::min(ROLLING_BLOCK, windows - first);
+			sums[0] = squares[0] = count[0] = 0;
+			if (w <= ROLLING_BLOCK){
+				end = w;
+				kernels.prefix(x.data + first, block + w - 1, sums.data(), squares.data(), count.data());
+			}else{
+				// Start rows at [0, block], end rows at [block + 1, 2 * block + 1]
+				end = block + 1;
+				sums[end] = s;
+				squares[end] = q;
+				count[end] = c;
+				kernels.prefix(x.data + first, block, sums.data(), squares.data(), count.data());
+				kernels.prefix(x.data + first + w, std::min(block, n - first - w), sums.data() + end,
+						squares.data() + end, count.data() + end);
+				s = sums[2 * block + 1] - sums[block];
+				q = squares[2 * block + 1] - squares[block];
+				c = count[2 * block + 1] - count[block];
+			}
+			kernels.window(sums.data(), squares.data(), count.data(), end + block - 1, end,
+					mean.data() + first, deviation.data() + first);
+		}
+	}
+
+	double analytics::correlation(columnSpan<float> x, columnSpan<float> y) const
+	{
+		pairMoments m;
+		double vx, vy;
+
+		kernels.moments(x.data, y.data, std::min(x.size, y.size), m);
+		if (m.count < 2){
+			return NAN;
+		}
+		vx = m.xx - m.x * m.x / m.count;
+		vy = m.yy - m.y * m.y / m.count;
+		return (m.xy - m.x * m.y / m.count) / sqrt(vx * vy);
+	}
+
+	//!******************************************************************************
+	//!	Name:	events()							*
+	//!	Description: The kernels compare the values with the level into a	*
+	//!	bit per row; runs start at the bits set after a clear one and end	*
+	//!	at the bits clear after a set one, found 64 rows at a time.		*
+	//!	Param : channel, level, minimum length, runs found (out)		*
+	//!	Returns: void								*
+	//!	Example: a.events(load, 50, 3, on);					*
+	//!******************************************************************************
+	void analytics::events(columnSpan<float> x, float level, size_t minimum,
+		std::vector<thresholdEvent> &out) const
+	{
+		std::vector<uint64_t> bits((x.size + 63) / 64);
+		uint64_t carry = 0, previous, changes;
+		size_t first = 0;
+
+		out.clear();
+		kernels.above(x.data, x.size, level, bits.data());
+		for (size_t w = 0; w < bits.size(); w++){
+			previous = (bits[w] << 1) | carry;
+			changes = bits[w] ^ previous;
+			carry = bits[w] >> 63;
+			while (changes){
+				size_t row = w * 64 + __builtin_ctzll(changes);
+				if (bits[w] & (changes & -changes)){
+					first = row;
+				}else if (row - first >= minimum){
+					out.push_back({first, row});
+				}
+				changes &= changes - 1;
+			}
+		}
+		// The bits past the last row are clear, so only a full last word leaves a run open
+		if (carry and (x.size - first >= minimum)){
+			out.push_back({first, x.size});
+		}
+	}
@@ -0,0 +1,78 @@
+/*
+ *  Batch analytics of the energy harvesting dataset
+ *
+ *  Resampling, integration, rolling statistics, correlation and
+ *  threshold events over the channels of a store (columnStore.h),
+ *  read in place from the mapping. The work is done by the kernels of
+ *  the widest instruction set of the CPU (kernels.h), chosen at run
+ *  time; the scalar kernels are the reference and the fallback.
+ *
+ *  An analytics object holds no state but the kernels, so one can be
+ *  shared by the threads of parallelFor().
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef analytics_h
+#define analytics_h
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "columnStore.h"
+#include "kernels.h"
+
+#define	ROLLING_BLOCK	(size_t)16384	// windows per block of prefix sums of rolling()
+
+//! Run of values at or above a level, rows [first, last)
+struct thresholdEvent {
+	size_t first;
+	size_t last;
+};
+
+//! Kernels the CPU can run, from the scalar ones to the widest
+std::vector<const analyticsKernels*> supportedKernels(void);
+
+//! Widest kernels of the CPU, or those named by ANALYTICS_KERNELS (scalar, sse4.1, avx2)
+const analyticsKernels &selectKernels(void);
+
+//! Runs task(i) for i in [0, count) on up to threads threads (0: one per core)
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)> &task);
+
+class analytics {
+	const analyticsKernels &kernels;
+	public:
+		explicit analytics(const analyticsKernels &k = selectKernels());
+
+		//! Name of the instruction set of the kernels
+		const char *name(void) const;
+
+		//! Mean of the values present, NaN if none
+		double mean(columnSpan<float> x) const;
+
+		//! Means of the values in bins of period s from start, NaN if a bin is empty
+		void resample(columnSpan<uint32_t> time, columnSpan<float> x, uint32_t start,
+			uint32_t period, size_t bins, std::vector<float> &out) const;
+
+		//! Integral of the values over the time (value x s), skipping steps longer than gap s
+		double integrate(columnSpan<uint32_t> time, columnSpan<float> x, uint32_t gap) const;
+
+		//! Integral of the product of two channels, as integrate()
+		double integrate(columnSpan<uint32_t> time, columnSpan<float> x, columnSpan<float> y,
+			uint32_t gap) const;
+
+		//! Mean and deviation of the windows of w values; element i covers x[i, i + w)
+		void rolling(columnSpan<float> x, size_t w, std::vector<float> &mean,
+			std::vector<float> &deviation) const;
+
+		//! Pearson correlation of the pairs present in both channels, NaN if undefined
+		double correlation(columnSpan<float> x, columnSpan<float> y) const;
+
+		//! Runs of at least minimum values at or above level
+		void events(columnSpan<float> x, float level, size_t minimum,
+			std::vector<thresholdEvent> &out) const;
+};
+
+#endif
@@ -0,0 +1,290 @@
+/*
+ *  Benchmark of the analytics kernels against the scalar path
+ *
+ *  Builds channels of synthetic samples (a day cycle of panel power
+ *  with noise, 1% missing, gaps in the time), runs every kernel of
+ *  every instruction set the CPU supports, checks the results against
+ *  the scalar kernels and prints the best time of each and its speedup.
+ *  It checks rolling() and events() of every instruction set against
+ *  plain loops, with windows longer than a block of rolling() over a
+ *  channel that is not a whole number of blocks. Then it runs the analytics of several channels on one thread and
+ *  on all of them.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -pthread -I../dataset -o analyticsbench analyticsbench.cpp \
+ *		analytics.cpp kernelsScalar.cpp kernelsSSE.cpp kernelsAVX2.cpp
+ *  Usage:
+ *	analyticsbench [-n samples] [-r repetitions] [-w window] [-c channels]
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "analytics.h"
+
+#define	TOLERANCE	1e-9	// relative error of the sums against the scalar kernels
+
+//! Outputs of the kernels, to compare them
+struct results {
+	double sum;
+	size_t count;
+	pairMoments moments;
+	double integral;
+	std::vector<float> product;
+	std::vector<double> sums, squares, count2;
+	std::vector<float> mean, deviation;
+	std::vector<uint64_t> bits;
+};
+
+//! Returns true if two doubles agree to TOLERANCE
+static bool close(double a, double b)
+{
+	return (a == b) or (fabs(a - b) <= TOLERANCE * fmax(fabs(a), fabs(b))) or (isnan(a) and isnan(b));
+}
+
+//! Returns true if two float arrays agree to a relative error
+static bool close(const std::vector<float> &a, const std::vector<float> &b, double tolerance)
+{
+	for (size_t i = 0; i < a.size(); i++){
+		if (!((a[i] == b[i]) or (isnan(a[i]) and isnan(b[i])) or
+				(fabs(a[i] - b[i]) <= tolerance * fmax(1.0, fabs(a[i]))))){
+			return false;
+		}
+	}
+	return a.size() == b.size();
+}
+
+//! Best time (ms) of a function over the repetitions
+template <typename F>
+static double best(unsigned repetitions, F f)
+{
+	double fastest = INFINITY;
+
+	for (unsigned r = 0; r < repetitions; r++){
+		auto start = std::chrono::steady_clock::now();
+		f();
+		fastest = fmin(fastest, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return fastest;
+}
+
+//! Checks rolling() and events() of every kernel against plain loops over a
+// channel of some blocks of rolling() and a part of one; returns true if they agree
+static bool reference(const std::vector<const analyticsKernels*> &kernels, size_t w)
+{
+	const size_t n = 3 * ROLLING_BLOCK + 1234;
+	const size_t windows[] = {w, ROLLING_BLOCK - 1, ROLLING_BLOCK, ROLLING_BLOCK + 1, 2 * ROLLING_BLOCK + 77, n};
+	std::mt19937 rng(2020);
+	std::normal_distribution<float> noise(0, 20);
+	std::uniform_real_distribution<float> uniform(0, 1);
+	std::vector<float> x(n);
+	std::vector<thresholdEvent> expected;
+	size_t first = 0, checked = 0;
+	bool ok = true;
+
+	for (size_t i = 0; i < n; i++){
+		x[i] = 300 + 200 * sinf(2 * M_PI * i / 20000) + noise(rng);
+		if (uniform(rng) < 0.01){
+			x[i] = NAN;
+		}
+	}
+	// Runs of at least 60 values at or above 250, NaN below it
+	for (size_t i = 0; i <= n; i++){
+		if ((i < n) and (x[i] >= 250)){
+			continue;
+		}
+		if (i - first >= 60){
+			expected.push_back({first, i});
+		}
+		first = i + 1;
+	}
+	for (const analyticsKernels *k : kernels){
+		const analytics a(*k);
+		std::vector<thresholdEvent> on;
+
+		a.events(columnSpan<float>{x.data(), n}, 250, 60, on);
+		if ((on.size() != expected.size()) or !std::equal(on.begin(), on.end(), expected.begin(),
+				[](const thresholdEvent &p, const thresholdEvent &q){ return (p.first == q.first) and (p.last == q.last); })){
+			fprintf(stderr, "%s: events differ from the reference\n", k->name);
+			ok = false;
+		}
+		for (size_t l : windows){
+			std::vector<float> mean, deviation;
+
+			if (l > n){
+				continue;
+			}
+			a.rolling(columnSpan<float>{x.data(), n}, l, mean, deviation);
+			if (mean.size() != n - l + 1){
+				fprintf(stderr, "%s: rolling of %zu gives %zu windows\n", k->name, l, mean.size());
+				ok = false;
+				continue;
+			}
+			// The first, second and last window of each block, some between, and the last one
+			for (size_t i = 0; i < mean.size(); i++){
+				size_t offset = i % ROLLING_BLOCK;
+				if ((offset > 1) and (offset < ROLLING_BLOCK - 1) and (i % 997 != 0) and (i + 1 < mean.size())){
+					continue;
+				}
+				double s = 0, c = 0, q = 0, m, d;
+				for (size_t j = i; j < i + l; j++){
+					if (!isnan(x[j])){
+						s += x[j];
+						c++;
+					}
+				}
+				m = s / c;
+				for (size_t j = i; j < i + l; j++){
+					if (!isnan(x[j])){
+						q += (x[j] - m) * (x[j] - m);
+					}
+				}
+				d = sqrt(q / (c - 1));
+				checked++;
+				if ((fabs(mean[i] - m) > 1e-6 * fmax(1, fabs(m))) or (fabs(deviation[i] - d) > 1e-5 * fmax(1, d))){
+					fprintf(stderr, "%s: rolling of %zu at %zu is %g, %g and not %g, %g\n", k->name, l, i,
+							mean[i], deviation[i], m, d);
+					ok = false;
+					break;
+				}
+			}
+		}
+	}
+	printf("rolling and events against the reference: %zu windows of %zu values, %zu events, %s\n\n",
+			checked, n, expected.size(), ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	size_t n = 1 << 24, w = 60;
+	unsigned repetitions = 5, channels = 8;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:w:c:")) != -1){
+		switch (opt){
+			case 'n': n = atol(optarg); break;
+			case 'r': repetitions = atoi(optarg); break;
+			case 'w': w = atol(optarg); break;
+			case 'c': channels = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n samples] [-r repetitions] [-w window] [-c channels]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((n < 2) or (w == 0) or (w > n) or (repetitions == 0) or (channels == 0)){
+		fprintf(stderr, "%s: needs 2 <= samples, 1 <= window <= samples\n", argv[0]);
+		return 1;
+	}
+
+	std::mt19937 rng(2019);
+	std::normal_distribution<float> noise(0, 20);
+	std::uniform_real_distribution<float> uniform(0, 1);
+	std::vector<uint32_t> time(n);
+	std::vector<float> panel(n), wind(n);
+	uint32_t t = 1546300800;
+
+	for (size_t i = 0; i < n; i++){
+		// A sample a second, with a gap of a few minutes now and then
+		t += (uniform(rng) < 0.0001) ? 300 : 1;
+		time[i] = t;
+		panel[i] = fmaxf(0, 500 * sinf(2 * M_PI * (t % 86400) / 86400) + noise(rng));
+		wind[i] = 3 + 0.004 * panel[i] + noise(rng) / 10;
+		if (uniform(rng) < 0.01){
+			panel[i] = NAN;
+		}
+		if (uniform(rng) < 0.01){
+			wind[i] = NAN;
+		}
+	}
+
+	std::vector<const analyticsKernels*> kernels = supportedKernels();
+	std::vector<results> out(kernels.size());
+	const char *names[] = {"sum", "moments", "multiply", "integrate", "prefix", "window", "above"};
+	std::vector<std::vector<double> > ms(kernels.size(), std::vector<double>(7));
+	bool ok = true;
+
+	for (size_t k = 0; k < kernels.size(); k++){
+		const analyticsKernels &K = *kernels[k];
+		results &r = out[k];
+		r.product.resize(n);
+		r.sums.resize(n + 1);
+		r.squares.resize(n + 1);
+		r.count2.resize(n + 1);
+		r.mean.resize(n - w + 1);
+		r.deviation.resize(n - w + 1);
+		r.bits.resize((n + 63) / 64);
+		ms[k][0] = best(repetitions, [&](){ K.sum(panel.data(), n, r.sum, r.count); });
+		ms[k][1] = best(repetitions, [&](){ K.moments(panel.data(), wind.data(), n, r.moments); });
+		ms[k][2] = best(repetitions, [&](){ K.multiply(panel.data(), wind.data(), n, r.product.data()); });
+		ms[k][3] = best(repetitions, [&](){ r.integral = K.integrate(time.data(), panel.data(), n, 60); });
+		ms[k][4] = best(repetitions, [&](){ K.prefix(panel.data(), n, r.sums.data(), r.squares.data(), r.count2.data()); });
+		ms[k][5] = best(repetitions, [&](){ K.window(r.sums.data(), r.squares.data(), r.count2.data(), n, w,
+								r.mean.data(), r.deviation.data()); });
+		ms[k][6] = best(repetitions, [&](){ K.above(panel.data(), n, 250, r.bits.data()); });
+
+		// Against the scalar kernels
+		const results &s = out[0];
+		const pairMoments &a = r.moments, &b = s.moments;
+		bool agree[7] = {
+			close(r.sum, s.sum) and (r.count == s.count),
+			(a.count == b.count) and close(a.x, b.x) and close(a.y, b.y) and close(a.xx, b.xx) and
+				close(a.yy, b.yy) and close(a.xy, b.xy),
+			close(r.product, s.product, 0),
+			close(r.integral, s.integral),
+			close(r.sums[n], s.sums[n]) and close(r.squares[n], s.squares[n]) and (r.count2[n] == s.count2[n]),
+			close(r.mean, s.mean, 1e-4) and close(r.deviation, s.deviation, 1e-3),
+			r.bits == s.bits
+		};
+		for (int i = 0; i < 7; i++){
+			if (!agree[i]){
+				fprintf(stderr, "%s: %s differs from scalar\n", K.name, names[i]);
+				ok = false;
+			}
+		}
+	}
+
+	ok = reference(kernels, w) and ok;
+	printf("%zu samples, window %zu, best of %u\n\n%-10s", n, w, repetitions, "kernel");
+	for (const analyticsKernels *k : kernels){
+		printf(" %10s %7s", k->name, "");
+	}
+	printf("\n");
+	for (int i = 0; i < 7; i++){
+		printf("%-10s", names[i]);
+		for (size_t k = 0; k < kernels.size(); k++){
+			printf(" %7.2f ms %5.2fx", ms[k][i], ms[0][i] / ms[k][i]);
+		}
+		printf("\n");
+	}
+
+	// Several channels, as energystats does with the stores
+	const analytics fast(*kernels.back());
+	auto all = [&](unsigned threads){
+		parallelFor(channels, threads, [&](size_t){
+			columnSpan<uint32_t> tc{time.data(), n};
+			columnSpan<float> pc{panel.data(), n}, wc{wind.data(), n};
+			std::vector<float> bins, mean, deviation;
+			std::vector<thresholdEvent> on;
+			fast.resample(tc, pc, time[0], 60, (time[n - 1] - time[0]) / 60 + 1, bins);
+			fast.integrate(tc, pc, 60);
+			fast.rolling(pc, w, mean, deviation);
+			fast.correlation(pc, wc);
+			fast.events(pc, 250, 60, on);
+		});
+	};
+	unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+	double one = best(repetitions, [&](){ all(1); });
+	double many = best(repetitions, [&](){ all(cores); });
+	printf("\n%u channels with %s: %.1f ms on 1 thread, %.1f ms on %u (%.2fx)\n",
+			channels, fast.name(), one, many, cores, one / many);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/*
+ *  Energy balance of the nodes from their columnar stores
+ *
+ *  For each store (one node or deployment, see tools/dataset/sd2col)
+ *  it integrates the panel, load and battery power, and resamples the
+ *  channels in bins to find the duty cycle of the load, the peak of the
+ *  rolling mean of the panel power and its correlation with the wind:
+ *
+ *	panel, load Wh		integral of panelPower, loadPower
+ *	battery Wh		integral of batteryVoltage x batteryCurrent,
+ *				signed as the INA219 of the battery reads it
+ *	efficiency		(battery + load) / panel
+ *	duty			bins with loadPower >= level / bins with data
+ *	peak mW			highest rolling mean of panelPower
+ *	wind r			correlation of windSpeed and panelPower bins
+ *
+ *  Stores are mapped once and the channels of all of them are
+ *  processed in parallel, then the statistics of each store.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -pthread -I../dataset -o energystats energystats.cpp \
+ *		analytics.cpp kernelsScalar.cpp kernelsSSE.cpp kernelsAVX2.cpp ../dataset/columnStore.cpp
+ *  Usage:
+ *	energystats [-p bin s] [-g gap s] [-w window s] [-l load mW] [-t threads] <store>...
+ *	ANALYTICS_KERNELS=scalar|sse4.1|avx2 chooses the kernels
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "analytics.h"
+
+#define	MW_S_PER_WH	3600000.0
+
+//! Channels resampled into bins
+enum binned {
+	BIN_PANEL,
+	BIN_LOAD,
+	BIN_WIND,
+	BINNED
+};
+
+static const char *const binnedNames[BINNED] = {"panelPower", "loadPower", "windSpeed"};
+
+//! A store and its results
+struct node {
+	const char *path;
+	columnStore store;
+	columnSpan<uint32_t> time;
+	size_t bins;
+	std::vector<float> bin[BINNED];
+	double panel, load, battery;	// mW s
+	double duty, peak, wind;
+};
+
+//! Channel of a store by name, empty if it is missing
+static columnSpan<float> channel(const columnStore &store, const char *name)
+{
+	int c = store.find(name);
+
+	if (c < 0){
+		return columnSpan<float>{NULL, 0};
+	}
+	return store.channel(c, 0, store.rows());
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t period = 60, gap = 600, span = 3600;
+	float level = 10;
+	unsigned threads = 0;
+	std::vector<std::unique_ptr<node> > nodes;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:g:w:l:t:")) != -1){
+		switch (opt){
+			case 'p': period = atoi(optarg); break;
+			case 'g': gap = atoi(optarg); break;
+			case 'w': span = atoi(optarg); break;
+			case 'l': level = atof(optarg); break;
+			case 't': threads = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-p bin s] [-g gap s] [-w window s] [-l load mW] [-t threads] <store>...\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((optind == argc) or (period == 0)){
+		fprintf(stderr, "usage: %s [-p bin s] [-g gap s] [-w window s] [-l load mW] [-t threads] <store>...\n", argv[0]);
+		return 1;
+	}
+	for (int a = optind; a < argc; a++){
+		nodes.emplace_back(new node());
+		nodes.back()->path = argv[a];
+		if (!nodes.back()->store.open(argv[a])){
+			return 1;
+		}
+		nodes.back()->time = nodes.back()->store.time(0, nodes.back()->store.rows());
+		const columnSpan<uint32_t> &t = nodes.back()->time;
+		nodes.back()->bins = t.size ? (t[t.size - 1] - t[0]) / period + 1 : 0;
+	}
+
+	const analytics a;
+	auto start = std::chrono::steady_clock::now();
+
+	// Every channel of every store: three integrals and the bins
+	const size_t tasks = 3 + BINNED;
+	parallelFor(nodes.size() * tasks, threads, [&](size_t i){
+		node &n = *nodes[i / tasks];
+		const columnStore &s = n.store;
+		size_t task = i % tasks;
+
+		switch (task){
+			case 0: n.panel = a.integrate(n.time, channel(s, "panelPower"), gap); break;
+			case 1: n.load = a.integrate(n.time, channel(s, "loadPower"), gap); break;
+			case 2: n.battery = a.integrate(n.time, channel(s, "batteryVoltage"), channel(s, "batteryCurrent"), gap); break;
+			default:
+				a.resample(n.time, channel(s, binnedNames[task - 3]), n.time.size ? n.time[0] : 0,
+						period, n.bins, n.bin[task - 3]);
+		}
+	});
+	// Statistics of the bins of each store
+	parallelFor(nodes.size(), threads, [&](size_t i){
+		node &n = *nodes[i];
+		columnSpan<float> panel{n.bin[BIN_PANEL].data(), n.bin[BIN_PANEL].size()};
+		columnSpan<float> load{n.bin[BIN_LOAD].data(), n.bin[BIN_LOAD].size()};
+		columnSpan<float> wind{n.bin[BIN_WIND].data(), n.bin[BIN_WIND].size()};
+		std::vector<thresholdEvent> on;
+		std::vector<float> mean, deviation;
+		size_t active = 0, present = 0;
+
+		a.events(load, level, 1, on);
+		for (const thresholdEvent &e : on){
+			active += e.last - e.first;
+		}
+		for (float v : load){
+			present += !isnan(v);
+		}
+		n.duty = present ? (double)active / present : NAN;
+		a.rolling(panel, std::max<size_t>(1, span / period), mean, deviation);
+		n.peak = NAN;
+		for (float v : mean){
+			if (!(v <= n.peak)){
+				n.peak = v;
+			}
+		}
+		n.wind = a.correlation(wind, panel);
+	});
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%-24s %8s %9s %9s %10s %10s %7s %9s %7s\n", "store", "days", "panel Wh", "load Wh",
+			"battery Wh", "efficiency", "duty", "peak mW", "wind r");
+	for (const std::unique_ptr<node> &n : nodes){
+		printf("%-24s %8.1f %9.2f %9.2f %10.2f %9.1f%% %6.1f%% %9.1f %7.3f\n", n->path,
+				n->bins * (double)period / 86400, n->panel / MW_S_PER_WH, n->load / MW_S_PER_WH,
+				n->battery / MW_S_PER_WH, 100 * (n->battery + n->load) / n->panel,
+				100 * n->duty, n->peak, n->wind);
+	}
+	printf("%s kernels, %.3f s\n", a.name(), seconds);
+	return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ *  Kernels of the analytics over contiguous channel arrays
+ *
+ *  Each instruction set provides the same kernels in its own file,
+ *  compiled for it with a target pragma, so one binary runs on any
+ *  x86-64 and uses AVX2 only where the CPU has it. The files only
+ *  include this header and the intrinsics: no template of the
+ *  standard library may be instantiated with the wider instructions,
+ *  since the linker could keep that copy for the scalar path.
+ *
+ *  Missing values are NaN and are skipped by every kernel. Sums are
+ *  accumulated in double, so the instruction sets agree to rounding.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef analyticsKernels_h
+#define analyticsKernels_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! Sums of the pairs of two channels present in both
+struct pairMoments {
+	double count;
+	double x, y;
+	double xx, yy, xy;
+};
+
+//! Kernels of an instruction set
+struct analyticsKernels {
+	const char *name;
+
+	//! Sum and number of the values present
+	void (*sum)(const float *x, size_t n, double &sum, size_t &count);
+
+	//! Sums of the pairs present in both channels
+	void (*moments)(const float *x, const float *y, size_t n, pairMoments &m);
+
+	//! Product of two channels, NaN where either is missing
+	void (*multiply)(const float *x, const float *y, size_t n, float *out);
+
+	//! Trapezoidal integral over the time (s), skipping steps longer than gap (< 2^31)
+	double (*integrate)(const uint32_t *time, const float *x, size_t n, uint32_t gap);
+
+	//! Inclusive prefix sums of the values, their squares and the values present,
+	// with n + 1 entries each following the entry 0 the caller sets, so a sum carries on
+	void (*prefix)(const float *x, size_t n, double *sum, double *squares, double *count);
+
+	//! Mean and standard deviation of the windows of w values from the prefix sums,
+	// n - w + 1 of them; NaN with fewer than 1 (mean) or 2 (deviation) values present
+	void (*window)(const double *sum, const double *squares, const double *count,
+		size_t n, size_t w, float *mean, float *deviation);
+
+	//! Bit i of the (n + 63) / 64 words: x[i] >= level (NaN is below)
+	void (*above)(const float *x, size_t n, float level, uint64_t *bits);
+};
+
+extern const analyticsKernels scalarKernels;
+#if defined(__x86_64__) or defined(__i386__)
+extern const analyticsKernels sseKernels;
+extern const analyticsKernels avx2Kernels;
+#endif
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ *  Kernels of the analytics: AVX2, 8 floats or 4 doubles per instruction
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include "kernels.h"
+
+#if defined(__x86_64__) or defined(__i386__)
+
+#pragma GCC target("avx2")
+#include <immintrin.h>
+
+//! Adds the 4 lanes
+static inline double total(__m256d v)
+{
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+//! Low and high 4 floats as doubles
+static inline __m256d low(__m256 v)
+{
+	return _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+}
+
+static inline __m256d high(__m256 v)
+{
+	return _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+}
+
+//! Mask of the lanes that are not NaN
+static inline __m256 present(__m256 v)
+{
+	return _mm256_cmp_ps(v, v, _CMP_ORD_Q);
+}
+
+//! Inclusive prefix sum of the 4 lanes, plus the carry of the previous ones
+static inline __m256d scan(__m256d v, __m256d carry)
+{
+	const __m256d zero = _mm256_setzero_pd();
+
+	v = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x1));
+	v = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x3));
+	return _mm256_add_pd(v, carry);
+}
+
+static void sum(const float *x, size_t n, double &result, size_t &count)
+{
+	__m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+	size_t i = 0;
+
+	count = 0;
+	// Two vectors per iteration, four chains of additions
+	for (; i + 16 <= n; i += 16){
+		__m256 u = _mm256_loadu_ps(x + i), v = _mm256_loadu_ps(x + i + 8);
+		__m256 mu = present(u), mv = present(v);
+		u = _mm256_and_ps(u, mu);
+		v = _mm256_and_ps(v, mv);
+		count += __builtin_popcount(_mm256_movemask_ps(mu)) + __builtin_popcount(_mm256_movemask_ps(mv));
+		a0 = _mm256_add_pd(a0, low(u));
+		a1 = _mm256_add_pd(a1, high(u));
+		a2 = _mm256_add_pd(a2, low(v));
+		a3 = _mm256_add_pd(a3, high(v));
+	}
+	result = total(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+	for (; i < n; i++){
+		if (!isnan(x[i])){
+			result += x[i];
+			count++;
+		}
+	}
+}
+
+static void moments(const float *x, const float *y, size_t n, pairMoments &m)
+{
+	__m256d sx = _mm256_setzero_pd(), sy = sx, sxx = sx, syy = sx, sxy = sx;
+	size_t i = 0, count = 0;
+
+	for (; i + 8 <= n; i += 8){
+		__m256 u = _mm256_loadu_ps(x + i), v = _mm256_loadu_ps(y + i);
+		__m256 both = _mm256_and_ps(present(u), present(v));
+		u = _mm256_and_ps(u, both);
+		v = _mm256_and_ps(v, both);
+		count += __builtin_popcount(_mm256_movemask_ps(both));
+		__m256d ul = low(u), uh = high(u), vl = low(v), vh = high(v);
+		sx = _mm256_add_pd(sx, _mm256_add_pd(ul, uh));
+		sy = _mm256_add_pd(sy, _mm256_add_pd(vl, vh));
+		sxx = _mm256_add_pd(sxx, _mm256_add_pd(_mm256_mul_pd(ul, ul), _mm256_mul_pd(uh, uh)));
+		syy = _mm256_add_pd(syy, _mm256_add_pd(_mm256_mul_pd(vl, vl), _mm256_mul_pd(vh, vh)));
+		sxy = _mm256_add_pd(sxy, _mm256_add_pd(_mm256_mul_pd(ul, vl), _mm256_mul_pd(uh, vh)));
+	}
+	m.count = count;
+	m.x = total(sx);
+	m.y = total(sy);
+	m.xx = total(sxx);
+	m.yy = total(syy);
+	m.xy = total(sxy);
+	for (; i < n; i++){
+		if (isnan(x[i]) or isnan(y[i])){
+			continue;
+		}
+		m.count++;
+		m.x += x[i];
+		m.y += y[i];
+		m.xx += (double)x[i] * x[i];
+		m.yy += (double)y[i] * y[i];
+		m.xy += (double)x[i] * y[i];
+	}
+}
+
+static void multiply(const float *x, const float *y, size_t n, float *out)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8){
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+	}
+	for (; i < n; i++){
+		out[i] = x[i] * y[i];
+	}
+}
+
+static double integrate(const uint32_t *time, const float *x, size_t n, uint32_t gap)
+{
+	const __m256i limit = _mm256_set1_epi32(gap);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	__m256d a0 = _mm256_setzero_pd(), a1 = a0;
+	double result;
+	size_t i = 0;
+
+	// Steps i to i + 1 for 8 values of i, reading up to i + 8
+	for (; i + 9 <= n; i += 8){
+		__m256i step = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(time + i + 1)),
+						_mm256_loadu_si256((const __m256i*)(time + i)));
+		__m256i short_ = _mm256_cmpeq_epi32(_mm256_min_epu32(step, limit), step);
+		__m256 s = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(x + i + 1));
+		__m256 term = _mm256_mul_ps(_mm256_mul_ps(half, s), _mm256_cvtepi32_ps(step));
+		term = _mm256_and_ps(term, _mm256_and_ps(_mm256_castsi256_ps(short_), present(s)));
+		a0 = _mm256_add_pd(a0, low(term));
+		a1 = _mm256_add_pd(a1, high(term));
+	}
+	result = total(_mm256_add_pd(a0, a1));
+	for (; i + 1 < n; i++){
+		uint32_t step = time[i + 1] - time[i];
+		float s = x[i] + x[i + 1];
+		if ((step <= gap) and !isnan(s)){
+			result += 0.5f * s * (float)step;
+		}
+	}
+	return result;
+}
+
+static void prefix(const float *x, size_t n, double *sums, double *squares, double *count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m256d cs = _mm256_set1_pd(sums[0]), cq = _mm256_set1_pd(squares[0]), cc = _mm256_set1_pd(count[0]);
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4){
+		__m128 v = _mm_loadu_ps(x + i);
+		__m128 m = _mm_cmpord_ps(v, v);
+		__m256d d = _mm256_cvtps_pd(_mm_and_ps(v, m));
+		cs = scan(d, cs);
+		cq = scan(_mm256_mul_pd(d, d), cq);
+		cc = scan(_mm256_cvtps_pd(_mm_and_ps(m, one)), cc);
+		_mm256_storeu_pd(sums + i + 1, cs);
+		_mm256_storeu_pd(squares + i + 1, cq);
+		_mm256_storeu_pd(count + i + 1, cc);
+		// The last lane carries to the next 4
+		cs = _mm256_permute4x64_pd(cs, _MM_SHUFFLE(3, 3, 3, 3));
+		cq = _mm256_permute4x64_pd(cq, _MM_SHUFFLE(3, 3, 3, 3));
+		cc = _mm256_permute4x64_pd(cc, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+	for (; i < n; i++){
+		bool valid = !isnan(x[i]);
+		double v = valid ? x[i] : 0;
+		sums[i + 1] = sums[i] + v;
+		squares[i + 1] = squares[i] + v * v;
+		count[i + 1] = count[i] + valid;
+	}
+}
+
+static void window(const double *sums, const double *squares, const double *count,
+	size_t n, size_t w, float *mean, float *deviation)
+{
+	const __m256d one = _mm256_set1_pd(1), two = _mm256_set1_pd(2), zero = _mm256_setzero_pd();
+	const __m256d none = _mm256_set1_pd(NAN);
+	size_t i = 0;
+
+	for (; i + w + 4 <= n + 1; i += 4){
+		__m256d c = _mm256_sub_pd(_mm256_loadu_pd(count + i + w), _mm256_loadu_pd(count + i));
+		__m256d s = _mm256_sub_pd(_mm256_loadu_pd(sums + i + w), _mm256_loadu_pd(sums + i));
+		__m256d q = _mm256_sub_pd(_mm256_loadu_pd(squares + i + w), _mm256_loadu_pd(squares + i));
+		__m256d m = _mm256_div_pd(s, c);
+		__m256d v = _mm256_div_pd(_mm256_sub_pd(q, _mm256_mul_pd(s, m)), _mm256_sub_pd(c, one));
+		v = _mm256_sqrt_pd(_mm256_max_pd(v, zero));
+		m = _mm256_blendv_pd(none, m, _mm256_cmp_pd(c, one, _CMP_GE_OQ));
+		v = _mm256_blendv_pd(none, v, _mm256_cmp_pd(c, two, _CMP_GE_OQ));
+		_mm_storeu_ps(mean + i, _mm256_cvtpd_ps(m));
+		_mm_storeu_ps(deviation + i, _mm256_cvtpd_ps(v));
+	}
+	for (; i + w <= n; i++){
+		double c = count[i + w] - count[i];
+		double s = sums[i + w] - sums[i];
+		double m = s / c;
+		double v = (squares[i + w] - squares[i] - s * m) / (c - 1);
+		mean[i] = (c >= 1) ? m : NAN;
+		deviation[i] = (c >= 2) ? sqrt(fmax(v, 0)) : NAN;
+	}
+}
+
+static void above(const float *x, size_t n, float level, uint64_t *bits)
+{
+	const __m256 l = _mm256_set1_ps(level);
+	size_t i = 0;
+
+	for (; i + 64 <= n; i += 64){
+		uint64_t word = 0;
+		for (int k = 0; k < 8; k++){
+			__m256 ge = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 8 * k), l, _CMP_GE_OQ);
+			word |= (uint64_t)_mm256_movemask_ps(ge) << (8 * k);
+		}
+		bits[i / 64] = word;
+	}
+	if (i < n){
+		bits[i / 64] = 0;
+	}
+	for (; i < n; i++){
+		if (x[i] >= level){
+			bits[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+}
+
+const analyticsKernels avx2Kernels = {"avx2", sum, moments, multiply, integrate, prefix, window, above};
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ *  Kernels of the analytics: SSE4.1, 4 floats or 2 doubles per instruction
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include "kernels.h"
+
+#if defined(__x86_64__) or defined(__i386__)
+
+#pragma GCC target("sse4.1")
+#include <immintrin.h>
+
+//! Adds the 2 lanes
+static inline double total(__m128d v)
+{
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+//! Low and high 2 floats as doubles
+static inline __m128d low(__m128 v)
+{
+	return _mm_cvtps_pd(v);
+}
+
+static inline __m128d high(__m128 v)
+{
+	return _mm_cvtps_pd(_mm_movehl_ps(v, v));
+}
+
+//! Inclusive prefix sum of the 2 lanes, plus the carry of the previous ones
+static inline __m128d scan(__m128d v, __m128d carry)
+{
+	return _mm_add_pd(_mm_add_pd(v, _mm_unpacklo_pd(_mm_setzero_pd(), v)), carry);
+}
+
+static void sum(const float *x, size_t n, double &result, size_t &count)
+{
+	__m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+	size_t i = 0;
+
+	count = 0;
+	for (; i + 8 <= n; i += 8){
+		__m128 u = _mm_loadu_ps(x + i), v = _mm_loadu_ps(x + i + 4);
+		__m128 mu = _mm_cmpord_ps(u, u), mv = _mm_cmpord_ps(v, v);
+		u = _mm_and_ps(u, mu);
+		v = _mm_and_ps(v, mv);
+		count += __builtin_popcount(_mm_movemask_ps(mu)) + __builtin_popcount(_mm_movemask_ps(mv));
+		a0 = _mm_add_pd(a0, low(u));
+		a1 = _mm_add_pd(a1, high(u));
+		a2 = _mm_add_pd(a2, low(v));
+		a3 = _mm_add_pd(a3, high(v));
+	}
+	result = total(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+	for (; i < n; i++){
+		if (!isnan(x[i])){
+			result += x[i];
+			count++;
+		}
+	}
+}
+
+static void moments(const float *x, const float *y, size_t n, pairMoments &m)
+{
+	__m128d sx = _mm_setzero_pd(), sy = sx, sxx = sx, syy = sx, sxy = sx;
+	size_t i = 0, count = 0;
+
+	for (; i + 4 <= n; i += 4){
+		__m128 u = _mm_loadu_ps(x + i), v = _mm_loadu_ps(y + i);
+		__m128 both = _mm_and_ps(_mm_cmpord_ps(u, u), _mm_cmpord_ps(v, v));
+		u = _mm_and_ps(u, both);
+		v = _mm_and_ps(v, both);
+		count += __builtin_popcount(_mm_movemask_ps(both));
+		__m128d ul = low(u), uh = high(u), vl = low(v), vh = high(v);
+		sx = _mm_add_pd(sx, _mm_add_pd(ul, uh));
+		sy = _mm_add_pd(sy, _mm_add_pd(vl, vh));
+		sxx = _mm_add_pd(sxx, _mm_add_pd(_mm_mul_pd(ul, ul), _mm_mul_pd(uh, uh)));
+		syy = _mm_add_pd(syy, _mm_add_pd(_mm_mul_pd(vl, vl), _mm_mul_pd(vh, vh)));
+		sxy = _mm_add_pd(sxy, _mm_add_pd(_mm_mul_pd(ul, vl), _mm_mul_pd(uh, vh)));
+	}
+	m.count = count;
+	m.x = total(sx);
+	m.y = total(sy);
+	m.xx = total(sxx);
+	m.yy = total(syy);
+	m.xy = total(sxy);
+	for (; i < n; i++){
+		if (isnan(x[i]) or isnan(y[i])){
+			continue;
+		}
+		m.count++;
+		m.x += x[i];
+		m.y += y[i];
+		m.xx += (double)x[i] * x[i];
+		m.yy += (double)y[i] * y[i];
+		m.xy += (double)x[i] * y[i];
+	}
+}
+
+static void multiply(const float *x, const float *y, size_t n, float *out)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4){
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+	}
+	for (; i < n; i++){
+		out[i] = x[i] * y[i];
+	}
+}
+
+static double integrate(const uint32_t *time, const float *x, size_t n, uint32_t gap)
+{
+	const __m128i limit = _mm_set1_epi32(gap);
+	const __m128 half = _mm_set1_ps(0.5f);
+	__m128d a0 = _mm_setzero_pd(), a1 = a0;
+	double result;
+	size_t i = 0;
+
+	for (; i + 5 <= n; i += 4){
+		__m128i step = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(time + i + 1)),
+						_mm_loadu_si128((const __m128i*)(time + i)));
+		__m128i short_ = _mm_cmpeq_epi32(_mm_min_epu32(step, limit), step);
+		__m128 s = _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(x + i + 1));
+		__m128 term = _mm_mul_ps(_mm_mul_ps(half, s), _mm_cvtepi32_ps(step));
+		term = _mm_and_ps(term, _mm_and_ps(_mm_castsi128_ps(short_), _mm_cmpord_ps(s, s)));
+		a0 = _mm_add_pd(a0, low(term));
+		a1 = _mm_add_pd(a1, high(term));
+	}
+	result = total(_mm_add_pd(a0, a1));
+	for (; i + 1 < n; i++){
+		uint32_t step = time[i + 1] - time[i];
+		float s = x[i] + x[i + 1];
+		if ((step <= gap) and !isnan(s)){
+			result += 0.5f * s * (float)step;
+		}
+	}
+	return result;
+}
+
+static void prefix(const float *x, size_t n, double *sums, double *squares, double *count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128d cs = _mm_set1_pd(sums[0]), cq = _mm_set1_pd(squares[0]), cc = _mm_set1_pd(count[0]);
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2){
+		__m128 v = _mm_castpd_ps(_mm_load_sd((const double*)(x + i)));
+		__m128 m = _mm_cmpord_ps(v, v);
+		__m128d d = _mm_cvtps_pd(_mm_and_ps(v, m));
+		cs = scan(d, cs);
+		cq = scan(_mm_mul_pd(d, d), cq);
+		cc = scan(_mm_cvtps_pd(_mm_and_ps(m, one)), cc);
+		_mm_storeu_pd(sums + i + 1, cs);
+		_mm_storeu_pd(squares + i + 1, cq);
+		_mm_storeu_pd(count + i + 1, cc);
+		// The last lane carries to the next 2
+		cs = _mm_unpackhi_pd(cs, cs);
+		cq = _mm_unpackhi_pd(cq, cq);
+		cc = _mm_unpackhi_pd(cc, cc);
+	}
+	for (; i < n; i++){
+		bool valid = !isnan(x[i]);
+		double v = valid ? x[i] : 0;
+		sums[i + 1] = sums[i] + v;
+		squares[i + 1] = squares[i] + v * v;
+		count[i + 1] = count[i] + valid;
+	}
+}
+
+static void window(const double *sums, const double *squares, const double *count,
+	size_t n, size_t w, float *mean, float *deviation)
+{
+	const __m128d one = _mm_set1_pd(1), two = _mm_set1_pd(2), zero = _mm_setzero_pd();
+	const __m128d none = _mm_set1_pd(NAN);
+	size_t i = 0;
+
+	for (; i + w + 2 <= n + 1; i += 2){
+		__m128d c = _mm_sub_pd(_mm_loadu_pd(count + i + w), _mm_loadu_pd(count + i));
+		__m128d s = _mm_sub_pd(_mm_loadu_pd(sums + i + w), _mm_loadu_pd(sums + i));
+		__m128d q = _mm_sub_pd(_mm_loadu_pd(squares + i + w), _mm_loadu_pd(squares + i));
+		__m128d m = _mm_div_pd(s, c);
+		__m128d v = _mm_div_pd(_mm_sub_pd(q, _mm_mul_pd(s, m)), _mm_sub_pd(c, one));
+		v = _mm_sqrt_pd(_mm_max_pd(v, zero));
+		m = _mm_blendv_pd(none, m, _mm_cmpge_pd(c, one));
+		v = _mm_blendv_pd(none, v, _mm_cmpge_pd(c, two));
+		_mm_storel_pi((__m64*)(mean + i), _mm_cvtpd_ps(m));
+		_mm_storel_pi((__m64*)(deviation + i), _mm_cvtpd_ps(v));
+	}
+	for (; i + w <= n; i++){
+		double c = count[i + w] - count[i];
+		double s = sums[i + w] - sums[i];
+		double m = s / c;
+		double v = (squares[i + w] - squares[i] - s * m) / (c - 1);
+		mean[i] = (c >= 1) ? m : NAN;
+		deviation[i] = (c >= 2) ? sqrt(fmax(v, 0)) : NAN;
+	}
+}
+
+static void above(const float *x, size_t n, float level, uint64_t *bits)
+{
+	const __m128 l = _mm_set1_ps(level);
+	size_t i = 0;
+
+	for (; i + 64 <= n; i += 64){
+		uint64_t word = 0;
+		for (int k = 0; k < 16; k++){
+			__m128 ge = _mm_cmpge_ps(_mm_loadu_ps(x + i + 4 * k), l);
+			word |= (uint64_t)_mm_movemask_ps(ge) << (4 * k);
+		}
+		bits[i / 64] = word;
+	}
+	if (i < n){
+		bits[i / 64] = 0;
+	}
+	for (; i < n; i++){
+		if (x[i] >= level){
+			bits[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+}
+
+const analyticsKernels sseKernels = {"sse4.1", sum, moments, multiply, integrate, prefix, window, above};
+
+#endif
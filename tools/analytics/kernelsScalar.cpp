@@ -0,0 +1,94 @@
+/*
+ *  Kernels of the analytics: portable scalar code, the reference
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include "kernels.h"
+
+static void sum(const float *x, size_t n, double &total, size_t &count)
+{
+	total = 0;
+	count = 0;
+	for (size_t i = 0; i < n; i++){
+		if (!isnan(x[i])){
+			total += x[i];
+			count++;
+		}
+	}
+}
+
+static void moments(const float *x, const float *y, size_t n, pairMoments &m)
+{
+	memset(&m, 0, sizeof(m));
+	for (size_t i = 0; i < n; i++){
+		if (isnan(x[i]) or isnan(y[i])){
+			continue;
+		}
+		m.count++;
+		m.x += x[i];
+		m.y += y[i];
+		m.xx += (double)x[i] * x[i];
+		m.yy += (double)y[i] * y[i];
+		m.xy += (double)x[i] * y[i];
+	}
+}
+
+static void multiply(const float *x, const float *y, size_t n, float *out)
+{
+	for (size_t i = 0; i < n; i++){
+		out[i] = x[i] * y[i];
+	}
+}
+
+static double integrate(const uint32_t *time, const float *x, size_t n, uint32_t gap)
+{
+	double total = 0;
+
+	for (size_t i = 0; i + 1 < n; i++){
+		uint32_t step = time[i + 1] - time[i];
+		float s = x[i] + x[i + 1];
+		if ((step <= gap) and !isnan(s)){
+			total += 0.5f * s * (float)step;
+		}
+	}
+	return total;
+}
+
+static void prefix(const float *x, size_t n, double *total, double *squares, double *count)
+{
+	for (size_t i = 0; i < n; i++){
+		bool present = !isnan(x[i]);
+		double v = present ? x[i] : 0;
+		total[i + 1] = total[i] + v;
+		squares[i + 1] = squares[i] + v * v;
+		count[i + 1] = count[i] + present;
+	}
+}
+
+static void window(const double *total, const double *squares, const double *count,
+	size_t n, size_t w, float *mean, float *deviation)
+{
+	for (size_t i = 0; i + w <= n; i++){
+		double c = count[i + w] - count[i];
+		double s = total[i + w] - total[i];
+		double m = s / c;
+		double v = (squares[i + w] - squares[i] - s * m) / (c - 1);
+		mean[i] = (c >= 1) ? m : NAN;
+		deviation[i] = (c >= 2) ? sqrt(fmax(v, 0)) : NAN;
+	}
+}
+
+static void above(const float *x, size_t n, float level, uint64_t *bits)
+{
+	memset(bits, 0, (n + 63) / 64 * sizeof(uint64_t));
+	for (size_t i = 0; i < n; i++){
+		if (x[i] >= level){
+			bits[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+}
+
+const analyticsKernels scalarKernels = {"scalar", sum, moments, multiply, integrate, prefix, window, above};
@@ -0,0 +1,122 @@
+/*
+ *  Replays a recorded trace through the adaptive sampler
+ *
+ *  The rows of a store (columnStore.h) are taken as the signal sampled
+ *  at the fixed rate of the deployment. The sampler of the nodes
+ *  (platform/adaptive.h) decides which rows would have been sampled,
+ *  the others are rebuilt by linear interpolation, and the error of
+ *  the panel power and the wind is compared with sampling every k rows
+ *  to take the same number of samples.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o adaptreplay adaptreplay.cpp \
+ *		columnStore.cpp ../../platform/adaptive.cpp
+ *  Usage:
+ *	adaptreplay [-m min s] [-M max s] [-p mW/s] [-w m/s/s] [-e mJ -b mW] <store>
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include "adaptive.h"
+#include "columnStore.h"
+
+//! Error of rebuilding a signal from the rows sampled
+struct replayError {
+	double rms;
+	double max;
+};
+
+static replayError rebuild(const columnSpan<uint32_t> &time, const columnSpan<float> &signal,
+	const std::vector<size_t> &taken)
+{
+	replayError error = {0, 0};
+	double sum = 0;
+	size_t n = 0;
+
+	for (size_t k = 0; k + 1 < taken.size(); k++){
+		size_t a = taken[k], b = taken[k + 1];
+		for (size_t i = a; i <= b; i++){
+			double f = (time[b] > time[a]) ? double(time[i] - time[a]) / (time[b] - time[a]) : 0;
+			double e = signal[a] + f * (signal[b] - signal[a]) - signal[i];
+			if (isnan(e)){
+				continue;
+			}
+			sum += e * e;
+			error.max = fmax(error.max, fabs(e));
+			n++;
+		}
+	}
+	error.rms = n ? sqrt(sum / n) : 0;
+	return error;
+}
+
+int main(int argc, char **argv)
+{
+	double minimum = 15, maximum = 600, panelRate = 5, windRate = 0.5, energy = 0, budget = 0;
+	columnStore store;
+	std::vector<size_t> adaptive, fixed;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:M:p:w:e:b:")) != -1){
+		switch (opt){
+			case 'm':	minimum = atof(optarg); break;
+			case 'M':	maximum = atof(optarg); break;
+			case 'p':	panelRate = atof(optarg); break;
+			case 'w':	windRate = atof(optarg); break;
+			case 'e':	energy = atof(optarg); break;
+			case 'b':	budget = atof(optarg); break;
+			default:	optind = argc + 1;
+		}
+	}
+	if (optind + 1 != argc){
+		fprintf(stderr, "usage: %s [-m min s] [-M max s] [-p mW/s] [-w m/s/s] [-e mJ -b mW] <store>\n", argv[0]);
+		return 1;
+	}
+	if (!store.open(argv[optind])){
+		return 1;
+	}
+	columnSpan<uint32_t> time = store.time(0, store.rows());
+	columnSpan<float> panel = store.channel("panelPower", 0, UINT32_MAX);
+	columnSpan<float> wind = store.channel("windSpeed", 0, UINT32_MAX);
+	if (time.size < 2 or panel.size != time.size or wind.size != time.size){
+		fprintf(stderr, "%s: needs time, panelPower and windSpeed\n", argv[optind]);
+		return 1;
+	}
+
+	adaptiveSampler sampler(minimum * 1000, maximum * 1000);
+	sampler.setPanelThreshold(panelRate, panelRate * 10);
+	sampler.setWindThreshold(windRate, windRate * 3);
+	if (energy > 0 and budget > 0){
+		sampler.setBudget(energy, budget);
+	}
+	// The sampler works with 32 bit milliseconds that wrap as millis() does
+	uint64_t next = 0;
+	for (size_t i = 0; i < time.size; i++){
+		uint64_t now = uint64_t(time[i] - time[0]) * 1000;
+		if (now >= next or i == time.size - 1){
+			adaptive.push_back(i);
+			next = now + sampler.update((uint32_t)now, panel[i], wind[i]);
+		}
+	}
+	size_t stride = (time.size + adaptive.size() - 1) / adaptive.size();
+	for (size_t i = 0; i < time.size; i += stride){
+		fixed.push_back(i);
+	}
+	if (fixed.back() != time.size - 1){
+		fixed.push_back(time.size - 1);
+	}
+
+	replayError ap = rebuild(time, panel, adaptive), aw = rebuild(time, wind, adaptive);
+	replayError fp = rebuild(time, panel, fixed), fw = rebuild(time, wind, fixed);
+	printf("rows      %zu\n", time.size);
+	printf("adaptive  %zu samples (%.1f%% fewer)  panel rms %.2f max %.2f mW  wind rms %.3f max %.3f m/s\n",
+		adaptive.size(), 100.0 * (1 - double(adaptive.size()) / time.size), ap.rms, ap.max, aw.rms, aw.max);
+	printf("fixed     %zu samples (every %zu)      panel rms %.2f max %.2f mW  wind rms %.3f max %.3f m/s\n",
+		fixed.size(), stride, fp.rms, fp.max, fw.rms, fw.max);
+	return 0;
+}
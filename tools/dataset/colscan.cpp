@@ -0,0 +1,78 @@
+/*
+ *  Describes a columnar store or scans one of its channels
+ *
+ *  Without a channel it prints the rows, time range and columns of the
+ *  store. With a channel it computes the count of values present, mean,
+ *  minimum and maximum between two unix times, reading the mapped
+ *  column in place, and reports the scan throughput.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -o colscan colscan.cpp columnStore.cpp
+ *  Usage:
+ *	colscan <store> [channel [from to]]
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "columnStore.h"
+
+int main(int argc, char **argv)
+{
+	columnStore store;
+	columnSpan<float> values;
+	uint32_t from = 0, to = UINT32_MAX;
+	double sum = 0;
+	float low = INFINITY, high = -INFINITY;
+	size_t count = 0;
+
+	if (argc != 2 and argc != 3 and argc != 5){
+		fprintf(stderr, "usage: %s <store> [channel [from to]]\n", argv[0]);
+		return 1;
+	}
+	if (!store.open(argv[1])){
+		return 1;
+	}
+	if (argc == 2){
+		columnSpan<uint32_t> t = store.time(0, store.rows());
+		printf("rows    %zu\n", store.rows());
+		if (t.size){
+			printf("time    %u - %u\n", t[0], t[t.size - 1]);
+		}
+		for (size_t c = 0; c < store.columns(); c++){
+			printf("column  %s\n", store.name(c));
+		}
+		return 0;
+	}
+	if (argc == 5){
+		from = strtoul(argv[3], NULL, 10);
+		to = strtoul(argv[4], NULL, 10);
+	}
+	if (store.find(argv[2]) < 0){
+		fprintf(stderr, "%s: no channel %s\n", argv[1], argv[2]);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	values = store.channel(argv[2], from, to);
+	for (float v : values){
+		if (!isnan(v)){
+			sum += v;
+			low = fminf(low, v);
+			high = fmaxf(high, v);
+			count++;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("rows    %zu (%zu present)\n", values.size, count);
+	if (count){
+		printf("mean    %g\nmin     %g\nmax     %g\n", sum / count, low, high);
+	}
+	printf("scan    %.3f ms, %.2f GB/s\n", seconds * 1e3,
+		values.size * sizeof(float) / (seconds > 0 ? seconds : 1) / 1e9);
+	return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ *  Columnar store of the energy harvesting dataset
+ *
+ *  Version 1.0
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include "columnStore.h"
+
+const char *const storeColumnNames[STORE_COLUMNS] = {
+	"time",
+	"panelCurrent", "panelPower", "loadCurrent", "loadPower",
+	"batteryCurrent", "batteryPower", "temperature", "humidity",
+	"batteryVoltage", "windSpeed"
+};
+
+//! Writes zeros up to the next multiple of STORE_ALIGN
+static bool pad(FILE *f, uint64_t &offset)
+{
+	static const uint8_t zeros[STORE_ALIGN] = {0};
+	size_t n = (STORE_ALIGN - offset % STORE_ALIGN) % STORE_ALIGN;
+
+	offset += n;
+	return fwrite(zeros, 1, n, f) == n;
+}
+
+bool writeStore(const std::string &path, const std::vector<uint32_t> &time,
+	const std::vector<std::vector<float> > &fields)
+{
+	std::vector<storeColumn> directory(fields.size() + 1);
+	storeFooter footer;
+	uint64_t offset = 0;
+	bool ok = true;
+	FILE *f = fopen(path.c_str(), "wb");
+
+	if (!f){
+		perror(path.c_str());
+		return false;
+	}
+	memset(directory.data(), 0, directory.size() * sizeof(storeColumn));
+	for (size_t c = 0; c < directory.size(); c++){
+		const char *name = (c < STORE_COLUMNS) ? storeColumnNames[c] : "unnamed";
+		strncpy(directory[c].name, name, sizeof(directory[c].name) - 1);
+		directory[c].type = (c == STORE_TIME) ? STORE_U32 : STORE_F32;
+		directory[c].offset = offset;
+		if (c == STORE_TIME){
+			ok = ok and fwrite(time.data(), sizeof(uint32_t), time.size(), f) == time.size();
+			offset += time.size() * sizeof(uint32_t);
+		}else{
+			const std::vector<float> &v = fields[c - 1];
+			ok = ok and v.size() == time.size();
+			ok = ok and fwrite(v.data(), sizeof(float), v.size(), f) == v.size();
+			offset += v.size() * sizeof(float);
+		}
+		ok = ok and pad(f, offset);
+	}
+	memset(&footer, 0, sizeof(footer));
+	footer.rows = time.size();
+	footer.columns = directory.size();
+	footer.firstTime = time.empty() ? 0 : time.front();
+	footer.lastTime = time.empty() ? 0 : time.back();
+	footer.version = STORE_VERSION;
+	memcpy(footer.magic, STORE_MAGIC, sizeof(footer.magic));
+	ok = ok and fwrite(directory.data(), sizeof(storeColumn), directory.size(), f) == directory.size();
+	ok = ok and fwrite(&footer, sizeof(footer), 1, f) == 1;
+	ok = (fclose(f) == 0) and ok;
+	if (!ok){
+		fprintf(stderr, "%s: write failed\n", path.c_str());
+	}
+	return ok;
+}
+
+columnStore::columnStore(void) : map(NULL), length(0), footer(NULL), directory(NULL)
+{
+}
+
+columnStore::~columnStore(void)
+{
+	close();
+}
+
+bool columnStore::open(const std::string &path)
+{
+	struct stat st;
+	int fd;
+	void *p;
+
+	close();
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0){
+		perror(path.c_str());
+		return false;
+	}
+	if (fstat(fd, &st) != 0 or (size_t)st.st_size < sizeof(storeFooter)){
+		fprintf(stderr, "%s: not a store\n", path.c_str());
+		::close(fd);
+		return false;
+	}
+	p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED){
+		perror(path.c_str());
+		return false;
+	}
+	map = (const uint8_t*)p;
+	length = st.st_size;
+	footer = (const storeFooter*)(map + length - sizeof(storeFooter));
+	if (memcmp(footer->magic, STORE_MAGIC, sizeof(footer->magic)) != 0 or
+			footer->version != STORE_VERSION or
+			footer->columns * sizeof(storeColumn) > length - sizeof(storeFooter)){
+		fprintf(stderr, "%s: not a store\n", path.c_str());
+		close();
+		return false;
+	}
+	directory = (const storeColumn*)((const uint8_t*)footer - footer->columns * sizeof(storeColumn));
+	for (size_t c = 0; c < footer->columns; c++){
+		if (directory[c].offset + footer->rows * 4 > (uint64_t)((const uint8_t*)directory - map)){
+			fprintf(stderr, "%s: column %zu out of the file\n", path.c_str(), c);
+			close();
+			return false;
+		}
+	}
+	// Scans read columns sequentially
+	madvise(p, length, MADV_SEQUENTIAL);
+	return true;
+}
+
+void columnStore::close(void)
+{
+	if (map){
+		munmap((void*)map, length);
+	}
+	map = NULL;
+	length = 0;
+	footer = NULL;
+	directory = NULL;
+}
+
+size_t columnStore::rows(void) const
+{
+	return footer ? footer->rows : 0;
+}
+
+size_t columnStore::columns(void) const
+{
+	return footer ? footer->columns : 0;
+}
+
+const char *columnStore::name(size_t column) const
+{
+	return (column < columns()) ? directory[column].name : "";
+}
+
+int columnStore::find(const std::string &name) const
+{
+	for (size_t c = 0; c < columns(); c++){
+		if (strncmp(directory[c].name, name.c_str(), sizeof(directory[c].name)) == 0){
+			return c;
+		}
+	}
+	return -1;
+}
+
+void columnStore::range(uint32_t from, uint32_t to, size_t &first, size_t &last) const
+{
+	columnSpan<uint32_t> t = time(0, rows());
+
+	first = std::lower_bound(t.begin(), t.end(), from) - t.begin();
+	last = std::lower_bound(t.begin() + first, t.end(), to) - t.begin();
+}
+
+columnSpan<uint32_t> columnStore::time(size_t first, size_t last) const
+{
+	columnSpan<uint32_t> span = {NULL, 0};
+
+	if (footer and footer->columns > STORE_TIME and first <= last and last <= rows()){
+		span.data = (const uint32_t*)(map + directory[STORE_TIME].offset) + first;
+		span.size = last - first;
+	}
+	return span;
+}
+
+columnSpan<float> columnStore::channel(size_t column, size_t first, size_t last) const
+{
+	columnSpan<float> span = {NULL, 0};
+
+	if (column < columns() and directory[column].type == STORE_F32 and first <= last and last <= rows()){
+		span.data = (const float*)(map + directory[column].offset) + first;
+		span.size = last - first;
+	}
+	return span;
+}
+
+columnSpan<float> columnStore::channel(const std::string &name, uint32_t from, uint32_t to) const
+{
+	columnSpan<float> span = {NULL, 0};
+	size_t first, last;
+	int column = find(name);
+
+	if (column < 0){
+		return span;
+	}
+	range(from, to, first, last);
+	return channel(column, first, last);
+}
@@ -0,0 +1,115 @@
+/*
+ *  Columnar store of the energy harvesting dataset
+ *
+ *  A store file holds one contiguous array per channel, sorted by
+ *  time, followed by a footer that indexes them:
+ *
+ *	[column 0][column 1]...[column n-1][storeColumn x n][storeFooter]
+ *
+ *  Columns start at multiples of STORE_ALIGN bytes. The footer is the
+ *  last sizeof(storeFooter) bytes of the file. Everything is little
+ *  endian. Missing values of float columns are NaN.
+ *
+ *  columnStore maps a file in memory and returns spans that point
+ *  into the mapping, so reading a channel copies nothing and a scan
+ *  runs at memory bandwidth instead of parsing text.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef columnStore_h
+#define columnStore_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define	STORE_MAGIC	"EHDSCOL1"
+#define	STORE_VERSION	1
+#define	STORE_ALIGN	64
+#define	STORE_TIME	0	// index of the time column
+#define	STORE_COLUMNS	11	// time and the ten fields of a sample
+
+//! Type of the values of a column
+enum storeType : uint32_t {
+	STORE_U32 = 0,
+	STORE_F32 = 1
+};
+
+//! Entry of the footer for each column
+struct storeColumn {
+	char name[24];			// NUL terminated
+	uint32_t type;			// storeType
+	uint32_t reserved;
+	uint64_t offset;		// from the start of the file
+} __attribute__((packed));
+
+//! Last bytes of a store file
+struct storeFooter {
+	uint64_t rows;			// values in every column
+	uint64_t columns;		// storeColumn entries before the footer
+	uint32_t firstTime;		// unix time of the first and last rows
+	uint32_t lastTime;
+	uint32_t version;		// STORE_VERSION
+	char magic[8];			// STORE_MAGIC, not terminated
+} __attribute__((packed));
+
+//! Channels written by the converters, in the order of writeSample()
+extern const char *const storeColumnNames[STORE_COLUMNS];
+
+//! Read-only view of consecutive values of a column
+template <typename T>
+struct columnSpan {
+	const T *data;
+	size_t size;
+	const T *begin(void) const { return data; }
+	const T *end(void) const { return data + size; }
+	const T &operator[](size_t i) const { return data[i]; }
+};
+
+//! Writes a store with the given columns (time first, sorted)
+bool writeStore(const std::string &path, const std::vector<uint32_t> &time,
+	const std::vector<std::vector<float> > &fields);
+
+class columnStore {
+	const uint8_t *map;
+	size_t length;
+	const storeFooter *footer;
+	const storeColumn *directory;
+	public:
+		columnStore(void);
+		~columnStore(void);
+
+		//! Maps a store file. Returns false if it is not valid
+		bool open(const std::string &path);
+
+		//! Unmaps the file; spans returned before become invalid
+		void close(void);
+
+		//! Number of rows of every column
+		size_t rows(void) const;
+
+		//! Number of columns and their names
+		size_t columns(void) const;
+		const char *name(size_t column) const;
+
+		//! Index of a column by name, or -1
+		int find(const std::string &name) const;
+
+		//! Rows with from <= time < to, as [first, last)
+		void range(uint32_t from, uint32_t to, size_t &first, size_t &last) const;
+
+		//! Time column between rows [first, last)
+		columnSpan<uint32_t> time(size_t first, size_t last) const;
+
+		//! Float column between rows [first, last); empty if it is not float
+		columnSpan<float> channel(size_t column, size_t first, size_t last) const;
+
+		//! Float column in a time range, by name; empty if not found
+		columnSpan<float> channel(const std::string &name, uint32_t from, uint32_t to) const;
+};
+
+#endif
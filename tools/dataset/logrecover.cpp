@@ -0,0 +1,188 @@
+/*
+ *  Finds the end of a block log (platform/blocklog.h) as open() does
+ *
+ *  With a log, prints its blocks, where writing resumes and the blocks
+ *  read to find it. With -t, builds a log of the given blocks in a
+ *  scratch file, tears its last block as a power loss would, and checks
+ *  that recover() resumes on it after reading O(log n) blocks. It then
+ *  cuts a record longer than a block after its first blocks, and checks
+ *  that recover() drops them. Last it tears the second block appended
+ *  over them, and checks that recover() resumes on it and not on one of
+ *  the dropped blocks after it.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o logrecover logrecover.cpp ../../platform/blocklog.cpp
+ *  Usage:
+ *	logrecover <log>
+ *	logrecover -t <blocks> <scratch file>
+ *
+ *  Version 1.0
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include "blocklog.h"
+
+//! Blocks of a file on the host
+class fileBlocks : public blockStore {
+	int fd;
+	public:
+		fileBlocks(int f) : fd(f) {}
+
+		bool readBlock(uint32_t index, uint8_t *block)
+		{
+			return pread(fd, block, LOG_BLOCK, (off_t)index * LOG_BLOCK) == LOG_BLOCK;
+		}
+
+		bool writeBlock(uint32_t index, const uint8_t *block)
+		{
+			return pwrite(fd, block, LOG_BLOCK, (off_t)index * LOG_BLOCK) == LOG_BLOCK;
+		}
+
+		uint32_t blocks(void)
+		{
+			struct stat st;
+
+			if (fstat(fd, &st) != 0){
+				return 0;
+			}
+			return (st.st_size + LOG_BLOCK - 1) / LOG_BLOCK;
+		}
+};
+
+//! Returns the ms since an instant
+static double elapsed(const struct timespec &start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+//! Recovers a log and prints where it resumes
+static uint32_t recover(int fd)
+{
+	fileBlocks store(fd);
+	blockLog log;
+	struct timespec start;
+	uint32_t next;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	next = log.recover(store);
+	printf("%u blocks, resumes at block %u, %u blocks read in %.3f ms\n",
+			store.blocks(), next, log.getReads(), elapsed(start));
+	return next;
+}
+
+//! Tears a block as a power loss would: the sector was half programmed
+static void tear(blockStore &store, uint32_t index)
+{
+	uint8_t block[LOG_BLOCK];
+
+	store.readBlock(index, block);
+	memset(block + LOG_BLOCK / 2, 0xFF, LOG_BLOCK / 2);
+	block[sizeof(logHeader)] ^= 1;
+	store.writeBlock(index, block);
+}
+
+//! Builds a log of about n blocks, tears the last one and recovers it; then
+// tears a record longer than a block before its end and recovers it, and
+// tears the block appended over its first blocks
+static int torture(uint32_t n, const char *path)
+{
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	fileBlocks store(fd);
+	blockLog log;
+	char line[LOG_PAYLOAD];
+	std::string longLine(3 * LOG_PAYLOAD, 'x');
+	uint32_t lines = 0, blocks;
+	int length = 0;
+
+	if (fd < 0){
+		perror(path);
+		return 1;
+	}
+	do {
+		length = snprintf(line, sizeof(line), "01.01.2019 00:00:00,%u\r\n", lines++);
+		if (log.append(store, line, length) != 0){
+			perror(path);
+			return 1;
+		}
+	} while (log.getNext() + 1 < n);
+	log.sync(store);
+	blocks = log.getNext();
+	printf("%u lines in %u blocks, %.1f lines a block\n", lines, blocks, (double)lines / blocks);
+	tear(store, blocks - 1);
+	if (recover(fd) != blocks - 1){
+		fprintf(stderr, "%s: the torn block was not found\n", path);
+		return 1;
+	}
+	// Recovering again after appending over it
+	blockLog again;
+	again.recover(store);
+	again.append(store, line, length);
+	again.sync(store);
+	if (log.recover(store) != blocks){
+		fprintf(stderr, "%s: the log does not resume after the torn block\n", path);
+		return 1;
+	}
+	// A power loss before the end of a long record: its first blocks are on the card
+	longLine += "\r\n";
+	log.append(store, longLine.data(), longLine.size());
+	if ((log.getNext() != blocks + 3) or (log.pending() != 2)){
+		fprintf(stderr, "%s: the long record did not fill 3 blocks\n", path);
+		return 1;
+	}
+	if (log.recover(store) != blocks){
+		fprintf(stderr, "%s: the first blocks of the torn record were not dropped\n", path);
+		return 1;
+	}
+	// Two blocks over the dropped ones, the second torn: no dropped block is left after it
+	log.append(store, line, length);
+	log.sync(store);
+	log.append(store, line, length);
+	log.sync(store);
+	tear(store, blocks + 1);
+	if (recover(fd) != blocks + 1){
+		fprintf(stderr, "%s: the log resumes after the torn block, on a dropped one\n", path);
+		return 1;
+	}
+	// Not torn, it is kept
+	log.recover(store);
+	log.append(store, longLine.data(), longLine.size());
+	log.sync(store);
+	if (recover(fd) != blocks + 5){
+		fprintf(stderr, "%s: the long record was not kept\n", path);
+		return 1;
+	}
+	close(fd);
+	printf("ok\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int fd;
+
+	if ((argc == 4) and (strcmp(argv[1], "-t") == 0) and (atol(argv[2]) > 0)){
+		return torture(atol(argv[2]), argv[3]);
+	}
+	if (argc != 2){
+		fprintf(stderr, "usage: %s <log>\n       %s -t <blocks> <scratch file>\n", argv[0], argv[0]);
+		return 1;
+	}
+	fd = open(argv[1], O_RDONLY);
+	if (fd < 0){
+		perror(argv[1]);
+		return 1;
+	}
+	recover(fd);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ *  Converts the SD logs of the nodes into a columnar store
+ *
+ *  The logs hold one line per sample as written by writeSample():
+ *
+ *	dd.mm.yyyy hh:mm:ss,panelCurrent,panelPower,...,windSpeed
+ *
+ *  with empty fields for values not read. Lines of several files are
+ *  merged, sorted by time and written as a store (columnStore.h).
+ *  Lines without a date or with a wrong number of fields are skipped.
+ *  Logs written in blocks (platform/blocklog.h) are read up to their
+ *  first invalid block, dropping the line torn by a power loss; older
+ *  logs are plain text.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o sd2col sd2col.cpp columnStore.cpp ../../platform/blocklog.cpp
+ *  Usage:
+ *	sd2col <store> <log>...
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include "blocklog.h"
+#include "columnStore.h"
+
+#define	FIELDS	(STORE_COLUMNS - 1)
+
+//! Days since 01.01.1970 of a civil date
+static int64_t days(int64_t y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = (unsigned)(y - era * 400);
+	const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int64_t)doe - 719468;
+}
+
+//! Reads n digits
+static bool digits(const char *&p, int n, int &value)
+{
+	value = 0;
+	for (int i = 0; i < n; i++, p++){
+		if (*p < '0' or *p > '9'){
+			return false;
+		}
+		value = value * 10 + (*p - '0');
+	}
+	return true;
+}
+
+//! Parses the date of a line (dd.mm.yyyy hh:mm:ss) into unix time
+static bool parseDate(const char *&p, uint32_t &time)
+{
+	int day, month, year, hour, minute, second;
+
+	if (!digits(p, 2, day) or *p++ != '.' or !digits(p, 2, month) or *p++ != '.' or
+			!digits(p, 4, year) or *p++ != ' ' or !digits(p, 2, hour) or *p++ != ':' or
+			!digits(p, 2, minute) or *p++ != ':' or !digits(p, 2, second)){
+		return false;
+	}
+	if (month < 1 or month > 12 or day < 1 or day > 31 or hour > 23 or minute > 59 or second > 60){
+		return false;
+	}
+	time = days(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+	return true;
+}
+
+//! Parses a line into its time and fields
+static bool parseLine(const char *p, uint32_t &time, float *fields)
+{
+	char *end;
+
+	if (!parseDate(p, time)){
+		return false;
+	}
+	for (int i = 0; i < FIELDS; i++){
+		if (*p++ != ','){
+			return false;
+		}
+		if (*p == ',' or *p == '\r' or *p == '\n' or *p == '\0'){
+			fields[i] = NAN;
+			continue;
+		}
+		fields[i] = strtof(p, &end);
+		if (end == p){
+			return false;
+		}
+		p = end;
+	}
+	return (*p == '\r' or *p == '\n' or *p == '\0');
+}
+
+//! Opens a log; the text of a block log is kept in text
+static FILE *openLog(const char *path, std::string &text)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t block[LOG_BLOCK];
+	logHeader header;
+	size_t end;
+
+	if (!f){
+		return NULL;
+	}
+	if ((fread(block, 1, LOG_BLOCK, f) != LOG_BLOCK) or !blockLog::valid(block, 0)){
+		// A text log
+		rewind(f);
+		return f;
+	}
+	text.clear();
+	for (uint32_t i = 0; blockLog::valid(block, i); i++){
+		memcpy(&header, block, sizeof(header));
+		text.append((const char*)block + sizeof(header), header.length);
+		if (fread(block, 1, LOG_BLOCK, f) != LOG_BLOCK){
+			break;
+		}
+	}
+	fclose(f);
+	// Every append ends with a line, anything after the last one is torn
+	end = text.rfind('\n');
+	text.resize((end == std::string::npos) ? 0 : end + 1);
+	return fmemopen((void*)text.data(), text.size(), "r");
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<uint32_t> time;
+	std::vector<std::vector<float> > fields(FIELDS);
+	unsigned long lines = 0, skipped = 0;
+	char line[512];
+	std::string text;
+	float values[FIELDS];
+	uint32_t t;
+
+	if (argc < 3){
+		fprintf(stderr, "usage: %s <store> <log>...\n", argv[0]);
+		return 1;
+	}
+	for (int a = 2; a < argc; a++){
+		FILE *f = openLog(argv[a], text);
+		if (!f){
+			perror(argv[a]);
+			return 1;
+		}
+		setvbuf(f, NULL, _IOFBF, 1 << 20);
+		while (fgets(line, sizeof(line), f)){
+			lines++;
+			if (!parseLine(line, t, values)){
+				skipped++;
+				continue;
+			}
+			time.push_back(t);
+			for (int i = 0; i < FIELDS; i++){
+				fields[i].push_back(values[i]);
+			}
+		}
+		fclose(f);
+	}
+
+	// Logs of a node are usually in order: sort only if needed
+	if (!std::is_sorted(time.begin(), time.end())){
+		std::vector<size_t> order(time.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return time[a] < time[b]; });
+		std::vector<uint32_t> sorted(time.size());
+		for (size_t r = 0; r < order.size(); r++){
+			sorted[r] = time[order[r]];
+		}
+		time.swap(sorted);
+		for (auto &column : fields){
+			std::vector<float> v(column.size());
+			for (size_t r = 0; r < order.size(); r++){
+				v[r] = column[order[r]];
+			}
+			column.swap(v);
+		}
+	}
+	if (!writeStore(argv[1], time, fields)){
+		return 1;
+	}
+	printf("%lu lines, %zu rows, %lu skipped\n", lines, time.size(), skipped);
+	return 0;
+}
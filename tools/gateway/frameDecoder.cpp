@@ -0,0 +1,47 @@
+/*
+ *  Decoder of the telemetry frames (platform/frame.h) in a byte stream
+ *
+ *  Version 1.0
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include "frameDecoder.h"
+
+frameDecoder::frameDecoder(void) : start(0), frames(0), crcErrors(0), skipped(0)
+{
+}
+
+void frameDecoder::feed(const uint8_t *data, size_t len)
+{
+	// Drop the decoded bytes before growing the buffer
+	if (start > 0 and start >= buffer.size() / 2){
+		buffer.erase(buffer.begin(), buffer.begin() + start);
+		start = 0;
+	}
+	buffer.insert(buffer.end(), data, data + len);
+}
+
+bool frameDecoder::next(TelemetryFrame &frame)
+{
+	while (buffer.size() - start >= sizeof(TelemetryFrame)){
+		const uint8_t *p = &buffer[start];
+		if (p[0] != FRAME_SYNC0 or p[1] != FRAME_SYNC1 or
+				p[2] != FRAME_VERSION or p[3] != sizeof(TelemetryFrame)){
+			start++;
+			skipped++;
+			continue;
+		}
+		memcpy(&frame, p, sizeof(frame));
+		if (frame.crc != frameCRC(p, offsetof(TelemetryFrame, crc))){
+			crcErrors++;
+			start++;
+			skipped++;
+			continue;
+		}
+		start += sizeof(TelemetryFrame);
+		frames++;
+		return true;
+	}
+	return false;
+}
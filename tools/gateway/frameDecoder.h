@@ -0,0 +1,38 @@
+/*
+ *  Decoder of the telemetry frames (platform/frame.h) in a byte stream
+ *
+ *  The gateway copies every LoRa packet to its serial port, so the
+ *  stream may hold other packets or noise between frames. The decoder
+ *  looks for the sync bytes and accepts a frame only when its version,
+ *  length and CRC are right; otherwise it skips one byte and resyncs.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef frameDecoder_h
+#define frameDecoder_h
+
+#include <stdint.h>
+#include <vector>
+#include "frame.h"
+
+class frameDecoder {
+	std::vector<uint8_t> buffer;
+	size_t start;			// first byte not decoded yet
+	public:
+		uint64_t frames;		// frames decoded
+		uint64_t crcErrors;		// frames with a wrong CRC
+		uint64_t skipped;		// bytes skipped looking for frames
+
+		frameDecoder(void);
+
+		//! Appends bytes of the stream
+		void feed(const uint8_t *data, size_t len);
+
+		//! Takes the next frame. Returns false when more bytes are needed
+		bool next(TelemetryFrame &frame);
+};
+
+#endif
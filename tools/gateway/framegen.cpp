@@ -0,0 +1,138 @@
+/*
+ *  Synthetic telemetry frames to exercise the gateway ingest
+ *
+ *  Simulates nodes sampling once a minute and writes their frames, as
+ *  the gateway would forward them, to stdout. The radio is imitated by
+ *  losing, duplicating, delaying and corrupting frames, and by noise
+ *  bytes between them. A node may reset, counting its frames from 0
+ *  again with another epoch. The expected counts go to stderr, for
+ *  ingest -x to check its report against them; delivered is the frames
+ *  with at least one copy not corrupted.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o framegen framegen.cpp
+ *  Usage:
+ *	framegen <nodes> <frames per node> [loss%] [dup%] [reorder%] [corrupt%] [reset%]
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+#include "adr.h"
+#include "frame.h"
+
+#define	PERIOD		60		// s between samples of a node
+#define	START		1546300800	// 01.01.2019 00:00:00
+#define	MAX_DELAY	8		// positions a frame can be delayed
+
+int main(int argc, char **argv)
+{
+	std::vector<std::vector<uint8_t> > out;
+	std::vector<uint32_t> id;			// frame of each entry of out
+	std::mt19937 rng(2019);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	unsigned nodes, frames;
+	double loss, dup, reorder, corrupt, reset;
+	unsigned long lost = 0, duplicated = 0, delayed = 0, corrupted = 0, resets = 0, delivered = 0;
+
+	if (argc < 3){
+		fprintf(stderr, "usage: %s <nodes> <frames per node> [loss%%] [dup%%] [reorder%%] [corrupt%%] [reset%%]\n",
+			argv[0]);
+		return 1;
+	}
+	nodes = atoi(argv[1]);
+	frames = atoi(argv[2]);
+	loss = (argc > 3) ? atof(argv[3]) / 100 : 0.01;
+	dup = (argc > 4) ? atof(argv[4]) / 100 : 0.02;
+	reorder = (argc > 5) ? atof(argv[5]) / 100 : 0.05;
+	corrupt = (argc > 6) ? atof(argv[6]) / 100 : 0.005;
+	reset = (argc > 7) ? atof(argv[7]) / 100 : 0.0;
+	std::vector<uint16_t> sequence(nodes, 0), epoch(nodes);
+	for (auto &e : epoch){
+		e = 1 + rng() % 0xFFFF;
+	}
+
+	for (unsigned i = 0; i < frames; i++){
+		for (unsigned node = 0; node < nodes; node++){
+			TelemetryFrame frame;
+			uint32_t time = START + i * PERIOD + node % PERIOD;
+			double sun = sin(M_PI * ((time % 86400) / 86400.0 * 2 - 0.5));
+			double panel = sun > 0 ? 2000 * sun * (0.7 + 0.3 * uniform(rng)) : 0;
+
+			if (uniform(rng) < reset){
+				uint16_t previous = epoch[node];
+				while (epoch[node] == previous){
+					epoch[node] = 1 + rng() % 0xFFFF;
+				}
+				sequence[node] = 0;
+				resets++;
+			}
+			frame.sync[0] = FRAME_SYNC0;
+			frame.sync[1] = FRAME_SYNC1;
+			frame.version = FRAME_VERSION;
+			frame.length = sizeof(frame);
+			frame.node = node;
+			frame.epoch = epoch[node];
+			frame.sequence = sequence[node]++;
+			frame.time = time;
+			frame.valid = 0x3F;
+			frame.link = FRAME_LINK(ADR_DEFAULT, 0);
+			frame.fields[0] = panel / 5.0;
+			frame.fields[1] = panel;
+			frame.fields[2] = 40 + 5 * uniform(rng);
+			frame.fields[3] = frame.fields[2] * 3.7;
+			frame.fields[4] = frame.fields[0] - frame.fields[2];
+			frame.fields[5] = frame.fields[4] * 3.7;
+			frame.fields[6] = 15 + 10 * sun;
+			frame.fields[7] = 60 - 20 * sun;
+			frame.fields[8] = 3.7 + 0.3 * sun;
+			frame.fields[9] = 8 * uniform(rng);
+			frame.crc = frameCRC((uint8_t*)&frame, offsetof(TelemetryFrame, crc));
+
+			if (uniform(rng) < loss){
+				lost++;
+				continue;
+			}
+			std::vector<uint8_t> bytes((uint8_t*)&frame, (uint8_t*)&frame + sizeof(frame));
+			out.push_back(bytes);
+			id.push_back(i * nodes + node);
+			if (uniform(rng) < dup){
+				out.push_back(bytes);
+				id.push_back(i * nodes + node);
+				duplicated++;
+			}
+		}
+	}
+	// Delay some frames a few positions and corrupt others
+	for (size_t i = 0; i + MAX_DELAY < out.size(); i++){
+		if (uniform(rng) < reorder){
+			size_t j = i + 1 + rng() % MAX_DELAY;
+			std::swap(out[i], out[j]);
+			std::swap(id[i], id[j]);
+			delayed++;
+		}
+	}
+	std::vector<bool> intact((size_t)nodes * frames, false);
+	for (size_t i = 0; i < out.size(); i++){
+		std::vector<uint8_t> &bytes = out[i];
+		if (uniform(rng) < corrupt){
+			bytes[4 + rng() % (bytes.size() - 4)] ^= 1 << (rng() % 8);
+			corrupted++;
+		}else if (!intact[id[i]]){
+			intact[id[i]] = true;
+			delivered++;
+		}
+		fwrite(bytes.data(), 1, bytes.size(), stdout);
+		if (uniform(rng) < 0.01){
+			fputs("DEBUG: noise", stdout);
+		}
+	}
+	fprintf(stderr, "frames %lu, lost %lu, duplicated %lu, delayed %lu, corrupted %lu, resets %lu, delivered %lu\n",
+		(unsigned long)nodes * frames, lost, duplicated, delayed, corrupted, resets, delivered);
+	return 0;
+}
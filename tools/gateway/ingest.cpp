@@ -0,0 +1,271 @@
+/*
+ *  Gateway ingest: stores the telemetry frames of the nodes
+ *
+ *  Reads the bytes forwarded by the gateway node (platform.forwardLoRa())
+ *  from its serial port, or a replay file, decodes the frames and hands
+ *  them to worker threads through lock-free queues. Each worker owns the
+ *  nodes with node % workers == its index, so it deduplicates, reorders
+ *  and appends their columns without locks (see nodeStore.h).
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -pthread -I../../platform -o ingest \
+ *		ingest.cpp frameDecoder.cpp nodeStore.cpp
+ *  Usage:
+ *	ingest [-w workers] [-r window] [-b baud] [-x expected] <input> <dir>
+ *	input is a serial device (/dev/tty*), a replay file or - for stdin
+ *	(e.g. framegen 300 1000 | ingest - data). With -x, the counts that
+ *	framegen wrote to the file expected are checked against the report
+ *	and any difference makes the exit status 1
+ *	(e.g. framegen 300 1000 2>expected | ingest -x expected - data)
+ *
+ *  Version 1.0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frameDecoder.h"
+#include "nodeStore.h"
+#include "spscQueue.h"
+
+#define	QUEUE_SIZE	8192	// frames per worker queue
+#define	READ_SIZE	65536	// bytes per read
+
+static std::atomic<bool> stop(false);
+
+static void interrupted(int)
+{
+	stop = true;
+}
+
+//! Worker: queue of frames and the store of its nodes
+struct worker {
+	spscQueue<TelemetryFrame> queue;
+	nodeStore store;
+	std::thread thread;
+	worker(const std::string &dir, unsigned window) : queue(QUEUE_SIZE), store(dir, window) {}
+};
+
+static void work(worker *w, const std::atomic<bool> *done)
+{
+	TelemetryFrame frame;
+
+	for (;;){
+		if (w->queue.pop(frame)){
+			w->store.add(frame);
+		}else if (done->load(std::memory_order_acquire)){
+			// The reader finished before this check: drain what is left
+			while (w->queue.pop(frame)){
+				w->store.add(frame);
+			}
+			break;
+		}else{
+			std::this_thread::yield();
+		}
+	}
+	w->store.flush();
+}
+
+//! Opens the input, setting a serial device to raw mode
+static int openInput(const char *path, speed_t baud)
+{
+	struct termios tty;
+	int fd;
+
+	if (strcmp(path, "-") == 0){
+		return STDIN_FILENO;
+	}
+	fd = open(path, O_RDONLY | O_NOCTTY);
+	if (fd < 0){
+		perror(path);
+		return -1;
+	}
+	if (isatty(fd)){
+		if (tcgetattr(fd, &tty) != 0){
+			perror(path);
+			close(fd);
+			return -1;
+		}
+		cfmakeraw(&tty);
+		cfsetispeed(&tty, baud);
+		cfsetospeed(&tty, baud);
+		tty.c_cc[VMIN] = 1;
+		tty.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tty);
+	}
+	return fd;
+}
+
+//! Report of the workers
+struct totals {
+	uint64_t frames, rows, duplicates, late, gaps, resets, failed;
+};
+
+//! Checks the report against the counts of framegen, true if they agree
+static bool check(const char *path, const totals &t)
+{
+	unsigned long frames, lost, duplicated, delayed, corrupted, resets, delivered;
+	uint64_t sent;
+	FILE *f = fopen(path, "r");
+	bool ok = true;
+	int n;
+
+	if (!f){
+		perror(path);
+		return false;
+	}
+	n = fscanf(f, "frames %lu, lost %lu, duplicated %lu, delayed %lu, corrupted %lu, resets %lu, delivered %lu",
+		&frames, &lost, &duplicated, &delayed, &corrupted, &resets, &delivered);
+	fclose(f);
+	if (n != 7){
+		fprintf(stderr, "%s: not the counts of framegen\n", path);
+		return false;
+	}
+	sent = frames - lost + duplicated;
+	// Every copy not corrupted is decoded...
+	if (t.frames != sent - corrupted){
+		fprintf(stderr, "expected %llu frames decoded\n", (unsigned long long)(sent - corrupted));
+		ok = false;
+	}
+	// ...and stored, dropped as a duplicate or dropped as late
+	if (t.rows + t.duplicates + t.late != t.frames){
+		fprintf(stderr, "stored, duplicates and late do not add up to the frames decoded\n");
+		ok = false;
+	}
+	// A frame delivered is stored, unless it arrived after its gap or epoch
+	if ((t.rows > delivered) or (delivered - t.rows > t.late)){
+		fprintf(stderr, "expected %lu frames stored, less those late\n", delivered);
+		ok = false;
+	}
+	if (t.resets > resets){
+		fprintf(stderr, "expected at most %lu resets\n", resets);
+		ok = false;
+	}
+	// A gap is a frame not delivered, or one that came after it was skipped
+	if (t.gaps > frames - delivered + t.late){
+		fprintf(stderr, "expected at most %llu gaps\n", (unsigned long long)(frames - delivered + t.late));
+		ok = false;
+	}
+	// Without resets, delays within the window are never late
+	if ((resets == 0) and ((t.rows != delivered) or (t.late != 0))){
+		fprintf(stderr, "expected %lu frames stored and none late\n", delivered);
+		ok = false;
+	}
+	return ok;
+}
+
+static speed_t baudRate(long baud)
+{
+	switch (baud){
+		case 9600:	return B9600;
+		case 57600:	return B57600;
+		case 230400:	return B230400;
+		case 460800:	return B460800;
+		case 921600:	return B921600;
+		default:	return B115200;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned workers = std::thread::hardware_concurrency();
+	unsigned window = 64;
+	long baud = 115200;
+	std::vector<std::unique_ptr<worker> > pool;
+	std::atomic<bool> done(false);
+	std::vector<uint8_t> buffer(READ_SIZE);
+	frameDecoder decoder;
+	struct sigaction action;
+	TelemetryFrame frame;
+	totals t = {0, 0, 0, 0, 0, 0, 0};
+	const char *expected = NULL;
+	int opt, fd;
+	ssize_t n;
+
+	while ((opt = getopt(argc, argv, "w:r:b:x:")) != -1){
+		switch (opt){
+			case 'w':	workers = atoi(optarg); break;
+			case 'r':	window = atoi(optarg); break;
+			case 'b':	baud = atol(optarg); break;
+			case 'x':	expected = optarg; break;
+			default:	optind = argc + 1;
+		}
+	}
+	if (optind + 2 != argc){
+		fprintf(stderr, "usage: %s [-w workers] [-r window] [-b baud] [-x expected] <input> <dir>\n", argv[0]);
+		return 1;
+	}
+	if (workers == 0){
+		workers = 1;
+	}
+	fd = openInput(argv[optind], baudRate(baud));
+	if (fd < 0){
+		return 1;
+	}
+	mkdir(argv[optind + 1], 0755);
+	// Without SA_RESTART so that Ctrl-C interrupts a blocking read
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = interrupted;
+	sigaction(SIGINT, &action, NULL);
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < workers; i++){
+		pool.emplace_back(new worker(argv[optind + 1], window));
+		pool.back()->thread = std::thread(work, pool.back().get(), &done);
+	}
+	while (!stop and (n = read(fd, buffer.data(), buffer.size())) != 0){
+		if (n < 0){
+			if (errno == EINTR){
+				continue;
+			}
+			perror("read");
+			break;
+		}
+		decoder.feed(buffer.data(), n);
+		while (decoder.next(frame)){
+			spscQueue<TelemetryFrame> &queue = pool[frame.node % workers]->queue;
+			while (!queue.push(frame)){
+				std::this_thread::yield();
+			}
+		}
+	}
+	done.store(true, std::memory_order_release);
+	for (auto &w : pool){
+		w->thread.join();
+		t.rows += w->store.rows;
+		t.duplicates += w->store.duplicates;
+		t.late += w->store.late;
+		t.gaps += w->store.gaps;
+		t.resets += w->store.resets;
+		t.failed += w->store.failed;
+	}
+	t.frames = decoder.frames;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("frames     %llu (%.0f frames/s, %u workers)\n", (unsigned long long)decoder.frames,
+		decoder.frames / (seconds > 0 ? seconds : 1), workers);
+	printf("stored     %llu\n", (unsigned long long)t.rows);
+	printf("duplicates %llu\n", (unsigned long long)t.duplicates);
+	printf("late       %llu\n", (unsigned long long)t.late);
+	printf("gaps       %llu\n", (unsigned long long)t.gaps);
+	printf("resets     %llu\n", (unsigned long long)t.resets);
+	printf("unwritten  %llu\n", (unsigned long long)t.failed);
+	printf("crc errors %llu (%llu bytes skipped)\n", (unsigned long long)decoder.crcErrors,
+		(unsigned long long)decoder.skipped);
+	if (expected and !check(expected, t)){
+		return 1;
+	}
+	return t.failed ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+/*
+ *  Per node storage of the telemetry frames received by the gateway
+ *
+ *  Version 1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "nodeStore.h"
+
+const char *const frameFieldNames[FRAME_FIELDS] = {
+	"panelCurrent", "panelPower", "loadCurrent", "loadPower",
+	"batteryCurrent", "batteryPower", "temperature", "humidity",
+	"batteryVoltage", "windSpeed"
+};
+
+//! Appends an array to a file
+template <typename T>
+static bool append(const std::string &path, const std::vector<T> &values)
+{
+	FILE *f = fopen(path.c_str(), "ab");
+	bool ok;
+
+	if (!f){
+		perror(path.c_str());
+		return false;
+	}
+	ok = (fwrite(values.data(), sizeof(T), values.size(), f) == values.size());
+	return (fclose(f) == 0) and ok;
+}
+
+nodeStore::nodeStore(const std::string &dir, unsigned window, size_t batch)
+	: dir(dir), window(1), batch(batch), rows(0), duplicates(0), late(0), gaps(0), resets(0), failed(0)
+{
+	// The window is indexed with the low bits of the sequence
+	while (this->window < window and this->window < 32768){
+		this->window <<= 1;
+	}
+}
+
+void nodeStore::add(const TelemetryFrame &frame)
+{
+	auto it = nodes.find(frame.node);
+	int diff;
+
+	if (it == nodes.end()){
+		nodeState fresh;
+		fresh.current = frame.epoch;
+		memset(fresh.previous, 0, sizeof(fresh.previous));
+		fresh.oldest = 0;
+		fresh.newest = frame.time;
+		fresh.next = frame.sequence;
+		fresh.stored = 0;
+		fresh.slot.resize(window);
+		fresh.used.assign(window, false);
+		it = nodes.emplace(frame.node, std::move(fresh)).first;
+	}
+	nodeState &node = it->second;
+
+	if (frame.epoch != node.current){
+		for (unsigned i = 0; i < NODE_EPOCHS; i++){
+			if (frame.epoch == node.previous[i]){
+				late++;
+				return;
+			}
+		}
+		// An epoch before the current one, whose frames were all delayed
+		if (frame.time < node.newest){
+			node.previous[node.oldest] = frame.epoch;
+			node.oldest = (node.oldest + 1) % NODE_EPOCHS;
+			late++;
+			return;
+		}
+		// The node was reset: its sequence starts again
+		drain(frame.node, node);
+		node.previous[node.oldest] = node.current;
+		node.oldest = (node.oldest + 1) % NODE_EPOCHS;
+		node.current = frame.epoch;
+		node.newest = frame.time;
+		node.next = frame.sequence;
+		node.stored = 0;
+		resets++;
+	}
+	if (frame.time > node.newest){
+		node.newest = frame.time;
+	}
+	diff = (int16_t)(frame.sequence - node.next);
+	if (diff < 0){
+		if (-diff <= 64 and ((node.stored >> (-diff - 1)) & 1)){
+			duplicates++;
+		}else{
+			late++;
+		}
+		return;
+	}
+	// Too far ahead: make room storing or skipping the oldest sequences
+	for (; diff >= (int)window; diff--){
+		unsigned k = node.next & (window - 1);
+		if (node.used[k]){
+			store(frame.node, node, node.slot[k]);
+		}else{
+			skip(node);
+		}
+	}
+	if (diff > 0){
+		unsigned k = frame.sequence & (window - 1);
+		if (node.used[k]){
+			duplicates++;
+		}else{
+			node.slot[k] = frame;
+			node.used[k] = true;
+		}
+		return;
+	}
+	store(frame.node, node, frame);
+	while (node.used[node.next & (window - 1)]){
+		store(frame.node, node, node.slot[node.next & (window - 1)]);
+	}
+}
+
+void nodeStore::flush(void)
+{
+	for (auto &it : nodes){
+		drain(it.first, it.second);
+		write(it.first, it.second);
+	}
+}
+
+void nodeStore::store(uint16_t id, nodeState &node, const TelemetryFrame &frame)
+{
+	node.used[frame.sequence & (window - 1)] = false;
+	node.time.push_back(frame.time);
+	node.epoch.push_back(frame.epoch);
+	node.sequence.push_back(frame.sequence);
+	node.valid.push_back(frame.valid);
+	for (int i = 0; i < FRAME_FIELDS; i++){
+		node.field[i].push_back(frame.fields[i]);
+	}
+	node.stored = (node.stored << 1) | 1;
+	node.next++;
+	rows++;
+	if (node.time.size() >= batch){
+		write(id, node);
+	}
+}
+
+void nodeStore::skip(nodeState &node)
+{
+	node.stored <<= 1;
+	node.next++;
+	gaps++;
+}
+
+//! Stores the frames waiting, skipping the sequences missing between them
+void nodeStore::drain(uint16_t id, nodeState &node)
+{
+	unsigned last = 0;
+
+	for (unsigned i = 0; i < window; i++){
+		if (node.used[(node.next + i) & (window - 1)]){
+			last = i + 1;
+		}
+	}
+	for (unsigned i = 0; i < last; i++){
+		unsigned k = node.next & (window - 1);
+		if (node.used[k]){
+			store(id, node, node.slot[k]);
+		}else{
+			skip(node);
+		}
+	}
+}
+
+void nodeStore::write(uint16_t id, nodeState &node)
+{
+	char name[16];
+	std::string path;
+	bool ok;
+
+	if (node.time.empty()){
+		return;
+	}
+	snprintf(name, sizeof(name), "/node_%05u/", id);
+	path = dir + name;
+	mkdir(path.c_str(), 0755);
+	// Every column is tried: a failed one leaves the rows of the others unaligned
+	ok = append(path + "time.u32", node.time);
+	ok = append(path + "epoch.u16", node.epoch) and ok;
+	ok = append(path + "sequence.u16", node.sequence) and ok;
+	ok = append(path + "valid.u16", node.valid) and ok;
+	for (int i = 0; i < FRAME_FIELDS; i++){
+		ok = append(path + frameFieldNames[i] + ".f32", node.field[i]) and ok;
+		node.field[i].clear();
+	}
+	if (!ok){
+		fprintf(stderr, "%s: %zu rows not written\n", path.c_str(), node.time.size());
+		failed += node.time.size();
+	}
+	node.time.clear();
+	node.epoch.clear();
+	node.sequence.clear();
+	node.valid.clear();
+}
@@ -0,0 +1,92 @@
+/*
+ *  Per node storage of the telemetry frames received by the gateway
+ *
+ *  Frames of each node are deduplicated by sequence number, put back
+ *  in order within a window and appended to one file per channel:
+ *
+ *	<dir>/node_<id>/time.u32		unix time (s)
+ *	<dir>/node_<id>/epoch.u16		reset epoch of the node
+ *	<dir>/node_<id>/sequence.u16		frame counter
+ *	<dir>/node_<id>/valid.u16		SAMPLE_* flags
+ *	<dir>/node_<id>/<field>.f32		one file per float field
+ *
+ *  Each file is a plain little endian array, so row i of every file
+ *  belongs to the same frame. A frame missing when the window is full
+ *  is counted as a gap and skipped; if it arrives later it is dropped
+ *  as late. The last 64 sequences stored are remembered, so a copy of
+ *  a frame further behind can no longer be told from a frame whose gap
+ *  was skipped and is counted as late, not as a duplicate. A store is
+ *  used by a single thread.
+ *
+ *  A node counts its frames from 0 again after a reset, with another
+ *  epoch. The first frame of a new epoch stores the frames waiting of
+ *  the previous one and starts the window at its sequence. The last
+ *  NODE_EPOCHS epochs of a node are remembered: frames of any of them
+ *  that arrive afterwards are dropped as late instead of starting the
+ *  window again. So is a frame of an epoch not seen yet but older than
+ *  the frames of the current one, delayed past the next reset.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef nodeStore_h
+#define nodeStore_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "frame.h"
+
+#define	NODE_EPOCHS	8		// epochs remembered before the current one
+
+//! Names of the float fields of a frame, in order
+extern const char *const frameFieldNames[FRAME_FIELDS];
+
+class nodeStore {
+	//! Reorder window and column buffers of a node
+	struct nodeState {
+		uint16_t current;			// epoch of the frames stored
+		uint16_t previous[NODE_EPOCHS];		// epochs before it, 0 if none (never an epoch)
+		unsigned oldest;			// slot of previous to replace next
+		uint32_t newest;			// latest time of the current epoch
+		uint16_t next;				// next sequence to store
+		uint64_t stored;			// bit i: sequence next-1-i stored
+		std::vector<TelemetryFrame> slot;	// frames waiting, by sequence
+		std::vector<bool> used;
+		std::vector<uint32_t> time;		// rows not written yet
+		std::vector<uint16_t> epoch;
+		std::vector<uint16_t> sequence;
+		std::vector<uint16_t> valid;
+		std::vector<float> field[FRAME_FIELDS];
+	};
+	std::string dir;
+	unsigned window;
+	size_t batch;
+	std::unordered_map<uint16_t, nodeState> nodes;
+
+	void store(uint16_t id, nodeState &node, const TelemetryFrame &frame);
+	void skip(nodeState &node);
+	void drain(uint16_t id, nodeState &node);
+	void write(uint16_t id, nodeState &node);
+	public:
+		uint64_t rows;			// frames stored
+		uint64_t duplicates;		// frames already stored or waiting
+		uint64_t late;			// frames arrived after their gap was skipped
+		uint64_t gaps;			// sequences never received
+		uint64_t resets;		// epochs started again by the nodes
+		uint64_t failed;		// rows stored that could not be written
+
+		//! Store in dir, reordering up to window frames, writing every batch rows
+		nodeStore(const std::string &dir, unsigned window, size_t batch = 4096);
+
+		//! Adds a frame received
+		void add(const TelemetryFrame &frame);
+
+		//! Stores the frames waiting and writes every buffer
+		void flush(void);
+};
+
+#endif
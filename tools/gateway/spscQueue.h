@@ -0,0 +1,57 @@
+/*
+ *  Lock-free single producer / single consumer queue
+ *
+ *  Bounded ring whose capacity is a power of two. The producer only
+ *  writes tail and the consumer only writes head, so no lock is
+ *  needed: each side publishes its index with release semantics
+ *  and reads the other one with acquire semantics.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this description is only included once
+#ifndef spscQueue_h
+#define spscQueue_h
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class spscQueue {
+	std::vector<T> ring;
+	size_t mask;
+	// Indexes on their own cache lines to avoid false sharing
+	alignas(64) std::atomic<size_t> head;	// next slot to pop (consumer)
+	alignas(64) std::atomic<size_t> tail;	// next slot to push (producer)
+	public:
+		//! Creates a queue with room for capacity (power of two) items
+		explicit spscQueue(size_t capacity) : ring(capacity), mask(capacity - 1), head(0), tail(0) {}
+
+		//! Adds an item (producer). Returns false if the queue is full
+		bool push(const T &item)
+		{
+			size_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) > mask){
+				return false;
+			}
+			ring[t & mask] = item;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		//! Takes an item (consumer). Returns false if the queue is empty
+		bool pop(T &item)
+		{
+			size_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire)){
+				return false;
+			}
+			item = ring[h & mask];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ *  Stress test of the queue of the background snapshots
+ *  (platform/sampleQueue.h) between two threads of a host
+ *
+ *  A producer thread push()es numbered records as fast as it can, as
+ *  TC4_Handler() does, and yields every few records. The consumer, as
+ *  drainSamples() does, takes about half of the records queued when it
+ *  looks, so records wait while the producer wraps around them. Every
+ *  record taken is checked: in order and with the fields the producer
+ *  wrote, and the records taken and dropped must add up to those
+ *  pushed. Any difference is printed and the exit status is 1.
+ *
+ *  By default it runs twice: yielding every SHORT_YIELD records, so
+ *  most records go through the queue, and every LONG_YIELD, so the
+ *  queue runs full and drops most of them. -y runs only the given one.
+ *
+ *  Build it also with -fsanitize=thread -g to check the memory order
+ *  of the indexes.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -pthread -I../../platform -o queuestress queuestress.cpp ../../platform/sampleQueue.cpp
+ *  Usage:
+ *	queuestress [-n records] [-y records between yields]
+ *
+ *  Version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include "sampleQueue.h"
+
+#define	SHORT_YIELD	8	// records between yields, most go through
+#define	LONG_YIELD	1024	// records between yields, the queue runs full
+
+//! Fields of record i, as the producer writes them
+static void fill(queuedSample &s, uint32_t i)
+{
+	s.time = i * 7;
+	s.sequence = i;
+	s.valid = i & 0x7FFF;
+	s.wind = i & 0x3FF;
+	s.loadCurrent = (float)(i & 0xFFFFF);
+	s.loadPower = (float)((i + 1) & 0xFFFFF);
+	s.batteryCurrent = -s.loadCurrent;
+	s.batteryPower = -s.loadPower;
+}
+
+//! Pushes records from a thread, yielding every yield records, and takes
+// them in this one; returns the records wrong
+static uint32_t stress(uint32_t records, uint32_t yield)
+{
+	sampleQueue queue;
+	std::atomic<bool> done(false);
+	uint32_t pushed = 0, taken = 0, wrong = 0;
+	int64_t last = -1;
+	queuedSample s, want;
+
+	std::thread producer([&](){
+		queuedSample p;
+		for (uint32_t i = 0; i < records; i++){
+			fill(p, i);
+			pushed += queue.push(p);
+			if (i % yield == 0){
+				std::this_thread::yield();
+			}
+		}
+		done = true;
+	});
+
+	while (!done or (queue.size() > 0)){
+		uint16_t queued = queue.size();
+		if (queued == 0){
+			std::this_thread::yield();
+			continue;
+		}
+		// Half of those queued, the oldest first
+		for (uint16_t n = (queued + 1) / 2; n > 0; n--){
+			if (!queue.pop(s)){
+				printf("record %u: the queue lost a record\n", taken);
+				wrong++;
+				break;
+			}
+			taken++;
+			fill(want, s.sequence);
+			if (((int64_t)s.sequence <= last) or (s.time != want.time) or (s.valid != want.valid) or
+					(s.wind != want.wind) or (s.loadCurrent != want.loadCurrent) or
+					(s.loadPower != want.loadPower) or (s.batteryCurrent != want.batteryCurrent) or
+					(s.batteryPower != want.batteryPower)){
+				printf("record %u: sequence %u after %lld, fields wrong\n", taken, s.sequence, (long long)last);
+				wrong++;
+			}
+			last = s.sequence;
+		}
+	}
+	producer.join();
+
+	if ((taken != pushed) or (pushed + queue.getOverflows() != records)){
+		printf("%u records, %u pushed, %u dropped, %u taken: they do not add up\n",
+			records, pushed, queue.getOverflows(), taken);
+		wrong++;
+	}
+	printf("%u records, a yield every %u: %u taken, %u dropped with the queue full (%.1f%%), "
+		"at most %u of %u queued: %u wrong\n", records, yield, taken, queue.getOverflows(),
+		100.0 * queue.getOverflows() / records, queue.getHighWater(), QUEUE_SAMPLES, wrong);
+	return wrong;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t records = 2000000, yield = 0, wrong;
+	bool both = true;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:y:")) != -1){
+		switch (opt){
+			case 'n': records = strtoul(optarg, NULL, 0); break;
+			case 'y': yield = strtoul(optarg, NULL, 0); both = false; break;
+			default:
+				fprintf(stderr, "usage: %s [-n records] [-y records between yields]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((records == 0) or (!both and (yield == 0))){
+		fprintf(stderr, "usage: %s [-n records] [-y records between yields]\n", argv[0]);
+		return 1;
+	}
+
+	if (both){
+		wrong = stress(records, SHORT_YIELD) + stress(records, LONG_YIELD);
+	}else{
+		wrong = stress(records, yield);
+	}
+	return wrong ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+/*
+ *  Simulation of the adaptive data rate of the LoRa uplink
+ *
+ *  Nodes scattered around the gateway send a TelemetryFrame in their
+ *  TDMA slot. The gateway chooses their setting with adrController
+ *  (platform/adr.h) from the SNR of the frames and tells it in the
+ *  acknowledgement; the nodes account their frames with adrStats.
+ *  The same nodes sending at the default setting and highest power,
+ *  as the library did before ADR, are the reference.
+ *
+ *  The SNR of a frame is the TX power minus a log-distance path loss,
+ *  a shadowing of each node and a fading of each frame, over the
+ *  thermal noise of the bandwidth. A frame, or an acknowledgement sent
+ *  by the gateway at the highest power, is received when its SNR is
+ *  over the floor of the setting.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o adrsim adrsim.cpp ../../platform/adr.cpp
+ *  Usage:
+ *	adrsim [-n nodes] [-f frames per node] [-r radius km] [-s shadowing dB] [-F fading dB]
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+#include "adr.h"
+#include "frame.h"
+
+#define	PATH_LOSS_1KM	125.0		// dB at 1 km
+#define	PATH_EXPONENT	3.0		// 10 * n dB per decade
+#define	NOISE_FIGURE	6.0		// dB of the receiver
+
+//! Totals of the frames sent with a setting by all the nodes
+struct settingTotals {
+	double sent;
+	double acked;
+	double bytes;
+	double airtime;			// ms
+	double energy;			// mJ
+};
+
+//! A node of the simulation
+struct simNode {
+	double loss;			// dB of path loss and shadowing
+	adrController node;		// setting at the node
+	adrController gateway;		// setting at the gateway
+	adrStats adaptive;
+	adrStats fixed;
+};
+
+//! Returns the SNR (dB) of a transmission
+static double snr(double power, double loss, uint32_t bandwidth, double fade)
+{
+	return power - loss - fade - (-174 + 10 * log10(bandwidth) + NOISE_FIGURE);
+}
+
+//! Adds the stats of a node to the totals of each setting and to their sum
+static void add(settingTotals totals[ADR_RATES][ADR_LEVELS], settingTotals &all, adrStats &stats)
+{
+	for (int r = 0; r < ADR_RATES; r++){
+		for (int l = 0; l < ADR_LEVELS; l++){
+			adrSetting s = stats.get(r, l);
+			totals[r][l].sent += s.sent;
+			totals[r][l].acked += s.acked;
+			totals[r][l].bytes += s.bytes;
+			totals[r][l].airtime += s.airtime;
+			totals[r][l].energy += s.energy;
+			all.sent += s.sent;
+			all.acked += s.acked;
+			all.bytes += s.bytes;
+			all.airtime += s.airtime;
+			all.energy += s.energy;
+		}
+	}
+}
+
+//! Prints ADR against fixed for a group of nodes
+static void compare(const char *name, unsigned nodes, const settingTotals &a, const settingTotals &f)
+{
+	if (nodes == 0){
+		return;
+	}
+	printf("%-10s %5u %8.1f%% %8.1f%% %8.0f%% %8.0f%%\n", name, nodes,
+			100 * a.acked / a.sent, 100 * f.acked / f.sent, 100 * a.airtime / f.airtime,
+			100 * (a.energy / a.bytes) / (f.energy / f.bytes));
+}
+
+//! Prints the totals of each setting used
+static void report(const char *name, settingTotals totals[ADR_RATES][ADR_LEVELS])
+{
+	settingTotals all = {0, 0, 0, 0, 0};
+
+	printf("%s\n%5s %8s %6s %8s %9s %11s %12s\n", name, "SF", "BW kHz", "dBm",
+			"frames", "delivery", "airtime s", "mJ/byte");
+	for (int r = 0; r < ADR_RATES; r++){
+		for (int l = 0; l < ADR_LEVELS; l++){
+			const settingTotals &t = totals[r][l];
+			if (t.sent == 0){
+				continue;
+			}
+			printf("%5u %8u %6d %8.0f %8.1f%% %11.1f %12.4f\n", adrRates[r].sf,
+					adrRates[r].bandwidth / 1000, adrPower(l), t.sent,
+					100 * t.acked / t.sent, t.airtime / 1000,
+					t.bytes ? t.energy / t.bytes : NAN);
+			all.sent += t.sent;
+			all.acked += t.acked;
+			all.bytes += t.bytes;
+			all.airtime += t.airtime;
+			all.energy += t.energy;
+		}
+	}
+	printf("%5s %8s %6s %8.0f %8.1f%% %11.1f %12.4f\n\n", "all", "", "", all.sent,
+			100 * all.acked / all.sent, all.airtime / 1000, all.bytes ? all.energy / all.bytes : NAN);
+}
+
+int main(int argc, char **argv)
+{
+	std::mt19937 rng(2019);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	unsigned nodes = 50, frames = 1000;
+	double radius = 6, shadowing = 6, fading = 3;
+	settingTotals adaptive[ADR_RATES][ADR_LEVELS] = {}, fixed[ADR_RATES][ADR_LEVELS] = {};
+	settingTotals adaptiveGroup[3] = {}, fixedGroup[3] = {};
+	unsigned group[3] = {0, 0, 0};
+	unsigned long changes = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:f:r:s:F:")) != -1){
+		switch (opt){
+			case 'n': nodes = atoi(optarg); break;
+			case 'f': frames = atoi(optarg); break;
+			case 'r': radius = atof(optarg); break;
+			case 's': shadowing = atof(optarg); break;
+			case 'F': fading = atof(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n nodes] [-f frames per node] [-r radius km] [-s shadowing dB] [-F fading dB]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (frames > 65535){
+		fprintf(stderr, "%s: at most 65535 frames per node\n", argv[0]);
+		return 1;
+	}
+
+	std::normal_distribution<double> shadow(0.0, shadowing);
+	std::normal_distribution<double> fade(0.0, fading);
+	std::vector<simNode> sim(nodes);
+
+	for (simNode &n : sim){
+		// Uniform over the disc, at least 100 m away
+		double d = fmax(0.1, radius * sqrt(uniform(rng)));
+		n.loss = PATH_LOSS_1KM + 10 * PATH_EXPONENT * log10(d) + shadow(rng);
+		n.gateway.allowRates(true);
+	}
+	for (unsigned i = 0; i < frames; i++){
+		for (simNode &n : sim){
+			uint8_t rate = n.node.getRate(), level = n.node.getLevel();
+			const loraRate &r = adrRates[rate];
+			const loraRate &d = adrRates[ADR_DEFAULT];
+			double up = snr(adrPower(level), n.loss, r.bandwidth, fade(rng));
+			double down = snr(adrPower(0), n.loss, r.bandwidth, fade(rng));
+			// The gateway listens with the setting it told the node
+			bool heard = (rate == n.gateway.getRate()) and (up >= r.floor);
+			bool acked = heard and (down >= r.floor);
+
+			if (heard){
+				n.gateway.heard(round(up), rate, level);
+				changes += n.gateway.decide(sizeof(TelemetryFrame));
+			}else{
+				n.gateway.missed();
+			}
+			if (acked){
+				n.node.set(n.gateway.getRate(), n.gateway.getLevel());
+			}else{
+				n.node.missed();
+			}
+			n.adaptive.account(rate, level, sizeof(TelemetryFrame), acked);
+
+			// Reference: default setting at the highest power
+			up = snr(adrPower(0), n.loss, d.bandwidth, fade(rng));
+			down = snr(adrPower(0), n.loss, d.bandwidth, fade(rng));
+			n.fixed.account(ADR_DEFAULT, 0, sizeof(TelemetryFrame), (up >= d.floor) and (down >= d.floor));
+		}
+	}
+	for (simNode &n : sim){
+		// Grouped by the delivery at the default setting
+		adrSetting s = n.fixed.get(ADR_DEFAULT, 0);
+		int g = (s.acked >= ADR_DELIVERY * s.sent) ? 0 : (s.acked >= 0.1 * s.sent) ? 1 : 2;
+
+		add(adaptive, adaptiveGroup[g], n.adaptive);
+		add(fixed, fixedGroup[g], n.fixed);
+		group[g]++;
+	}
+
+	printf("%u nodes within %.1f km, %u frames each, shadowing %.0f dB, fading %.0f dB\n\n",
+			nodes, radius, frames, shadowing, fading);
+	report("ADR", adaptive);
+	report("fixed", fixed);
+	// Strong links save energy; weak ones buy delivery with airtime
+	printf("%-10s %5s %9s %9s %9s %9s\n", "delivery", "nodes", "ADR", "fixed", "airtime", "mJ/byte");
+	compare(">= 90%", group[0], adaptiveGroup[0], fixedGroup[0]);
+	compare("10-90%", group[1], adaptiveGroup[1], fixedGroup[1]);
+	compare("< 10%", group[2], adaptiveGroup[2], fixedGroup[2]);
+	printf("%.2f changes of setting per node and 100 frames\n", 100.0 * changes / nodes / frames);
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ *  Simulation of the LoRa uplink with ALOHA and with time slots
+ *
+ *  Nodes sample once a period of their clock, at a random phase, and send a
+ *  TelemetryFrame. With ALOHA they send it at once; with TDMA they
+ *  wait for their slot with the scheduler of the nodes
+ *  (platform/tdma.h). Slot 0 is left for the beacons of the gateway.
+ *
+ *  Each node has its own clock: a drift (ppm) and an initial error,
+ *  as left by enableTDMA() with an RTC set by hand. The beacons set the
+ *  network time again with a small jitter of the reception. Two
+ *  transmissions that overlap are both lost (same channel and spreading
+ *  factor, no capture effect).
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o tdmasim tdmasim.cpp ../../platform/tdma.cpp
+ *  Usage:
+ *	tdmasim [-p period s] [-g guard ms] [-d drift ppm] [-i initial error ms]
+ *		[-b beacon interval s, 0 none] [-t hours] [nodes ...]
+ *
+ *  Version 1.0
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+#include "airtime.h"
+#include "frame.h"
+#include "tdma.h"
+
+#define	LORA_SF		7
+#define	LORA_BW		125000
+#define	LORA_CR		1
+#define	BEACON_JITTER	2.0		// ms of error of a beacon reception
+#define	RH_HEADER	4		// bytes RadioHead sends before a frame
+
+//! A transmission on the channel (ms of true time)
+struct transmission {
+	double start;
+	double end;
+	bool beacon;
+};
+
+//! Results of one run
+struct runResult {
+	unsigned long sent;		// frames transmitted
+	unsigned long collided;		// frames overlapped by another transmission
+	unsigned long dropped;		// samples replaced before their slot came
+	double delivered;		// frames per minute received
+	double latency;			// mean ms from the sample to the transmission
+};
+
+//! Simulation settings
+struct simConfig {
+	double period;			// ms between samples of a node
+	double guard;			// ms
+	double drift;			// ppm, the nodes take +-drift
+	double initial;			// ms, the nodes start +-initial apart
+	double beacon;			// ms between beacons, 0 none
+	double duration;		// ms
+};
+
+//! Counts the transmissions overlapped by another one
+static void collide(std::vector<transmission> &tx, runResult &r)
+{
+	double busy = -1;
+	size_t owner = 0;
+	std::vector<bool> hit(tx.size(), false);
+
+	std::sort(tx.begin(), tx.end(), [](const transmission &a, const transmission &b){
+		return a.start < b.start;
+	});
+	// The transmission that ends last so far overlaps the next one if it has not ended
+	for (size_t i = 0; i < tx.size(); i++){
+		if (tx[i].start < busy){
+			hit[i] = true;
+			hit[owner] = true;
+		}
+		if (tx[i].end > busy){
+			busy = tx[i].end;
+			owner = i;
+		}
+	}
+	for (size_t i = 0; i < tx.size(); i++){
+		if (!tx[i].beacon){
+			r.sent++;
+			r.collided += hit[i];
+		}
+	}
+}
+
+//! Runs nodes with ALOHA (slotted = false) or TDMA
+static runResult simulate(unsigned nodes, bool slotted, const simConfig &c, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+	std::normal_distribution<double> jitter(0.0, BEACON_JITTER);
+	std::vector<transmission> tx;
+	runResult r = {0, 0, 0, 0, 0};
+	double airtime = loraAirtime(sizeof(TelemetryFrame) + RH_HEADER, LORA_SF, LORA_BW, LORA_CR) / 1000.0;
+	double beaconAirtime = loraAirtime(sizeof(BeaconFrame) + RH_HEADER, LORA_SF, LORA_BW, LORA_CR) / 1000.0;
+	uint32_t slotLength = (uint32_t)ceil(airtime) + 1 + 2 * (uint32_t)c.guard;
+	double frame = (double)slotLength * (nodes + 1);
+	double every = ceil(c.beacon / frame) * frame;		// beacons at the start of a frame
+	double latency = 0;
+
+	// The gateway sends its beacons in slot 0
+	for (double t = every; slotted and (every > 0) and (t < c.duration); t += every){
+		tx.push_back({t + c.guard, t + c.guard + beaconAirtime, true});
+	}
+	for (unsigned n = 1; n <= nodes; n++){
+		tdmaScheduler tdma;
+		double rate = 1 + c.drift * uniform(rng) * 1e-6;	// local ms per true ms
+		double offset = c.initial * uniform(rng);		// local minus true ms
+		double phase = c.period * (uniform(rng) + 1) / 2;
+		double synced = 0, pending = -1, sampled = 0;
+
+		tdma.configure(n, nodes + 1, slotLength, (uint32_t)c.guard);
+		// enableTDMA() at the start, with the error of the RTC
+		tdma.correct(0, (uint64_t)llround(offset));
+		// Samples are taken once a period of the local clock
+		for (double l = phase; (l - offset) / rate < c.duration; l += c.period){
+			double t = (l - offset) / rate, start;
+
+			if (!slotted){
+				tx.push_back({t, t + airtime, false});
+				continue;
+			}
+			// Beacons received since the last sample
+			while ((every > 0) and (synced + every <= t)){
+				synced += every;
+				tdma.correct((uint64_t)llround(synced + jitter(rng)), (uint64_t)llround(synced * rate + offset));
+			}
+			// Wait for the slot in the local clock
+			start = t + tdma.wait((uint64_t)llround(t * rate + offset), (uint32_t)ceil(airtime)) / rate;
+			// A sample still waiting is replaced by the new one
+			if ((pending >= 0) and (pending > t)){
+				r.dropped++;
+				tx.pop_back();
+				latency -= pending - sampled;
+			}
+			tx.push_back({start, start + airtime, false});
+			latency += start - t;
+			pending = start;
+			sampled = t;
+		}
+	}
+	collide(tx, r);
+	r.delivered = (r.sent - r.collided) / (c.duration / 60000.0);
+	r.latency = r.sent ? latency / r.sent : 0;
+	return r;
+}
+
+int main(int argc, char **argv)
+{
+	simConfig c = {60000, 20, 20, 1000, 600000, 24 * 3600000.0};
+	std::vector<unsigned> nodes;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:g:d:i:b:t:")) != -1){
+		switch (opt){
+			case 'p': c.period = atof(optarg) * 1000; break;
+			case 'g': c.guard = atof(optarg); break;
+			case 'd': c.drift = atof(optarg); break;
+			case 'i': c.initial = atof(optarg); break;
+			case 'b': c.beacon = atof(optarg) * 1000; break;
+			case 't': c.duration = atof(optarg) * 3600000; break;
+			default:
+				fprintf(stderr, "usage: %s [-p period s] [-g guard ms] [-d drift ppm] [-i initial ms] [-b beacon s] [-t hours] [nodes ...]\n", argv[0]);
+				return 1;
+		}
+	}
+	for (int i = optind; i < argc; i++){
+		nodes.push_back(atoi(argv[i]));
+	}
+	if (nodes.empty()){
+		nodes = {10, 25, 50, 100, 200, 300, 400, 500};
+	}
+
+	printf("airtime %.1f ms, period %.0f s, guard %.0f ms, drift %.0f ppm, initial %.0f ms, beacon %.0f s\n",
+			loraAirtime(sizeof(TelemetryFrame) + RH_HEADER, LORA_SF, LORA_BW, LORA_CR) / 1000.0,
+			c.period / 1000, c.guard, c.drift, c.initial, c.beacon / 1000);
+	printf("%6s %8s | %10s %10s | %10s %10s %8s %10s\n", "nodes", "offered",
+			"aloha lost", "frames/min", "tdma lost", "frames/min", "dropped", "wait ms");
+	for (unsigned n : nodes){
+		runResult aloha = simulate(n, false, c, n);
+		runResult tdma = simulate(n, true, c, n);
+		double offered = n * (loraAirtime(sizeof(TelemetryFrame) + RH_HEADER, LORA_SF, LORA_BW, LORA_CR) / 1000.0) / c.period;
+
+		printf("%6u %8.3f | %9.2f%% %10.1f | %9.2f%% %10.1f %8lu %10.0f\n", n, offered,
+				100.0 * aloha.collided / aloha.sent, aloha.delivered,
+				100.0 * tdma.collided / tdma.sent, tdma.delivered, tdma.dropped, tdma.latency);
+	}
+	return 0;
+}
@@ -0,0 +1,12 @@
+/*
+ *  Adafruit GFX of the replay on a host
+ *
+ *  Version 1.0
+ */
+
+#ifndef Adafruit_GFX_h
+#define Adafruit_GFX_h
+
+#include "Arduino.h"
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ *  INA219 of the replay on a host: it reads 0, the values are those of
+ *  the trace
+ *
+ *  Version 1.0
+ */
+
+#ifndef Adafruit_INA219_h
+#define Adafruit_INA219_h
+
+#include "Arduino.h"
+
+class Adafruit_INA219 {
+	public:
+		Adafruit_INA219(uint8_t) {}
+		void begin(void) {}
+		float getCurrent_mA(void) { replayAdvance(REPLAY_I2C); return 0; }
+		float getPower_mW(void) { replayAdvance(REPLAY_I2C); return 0; }
+		float getBusVoltage_V(void) { replayAdvance(REPLAY_I2C); return 0; }
+};
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ *  SSD1306 display of the replay on a host: the text is dropped
+ *
+ *  Version 1.0
+ */
+
+#ifndef Adafruit_SSD1306_h
+#define Adafruit_SSD1306_h
+
+#include "Adafruit_GFX.h"
+
+#define	SSD1306_SWITCHCAPVCC	0x02
+#define	WHITE			1
+#define	BLACK			0
+
+class Adafruit_SSD1306 : public Print {
+	public:
+		Adafruit_SSD1306(int8_t) {}
+		bool begin(uint8_t, uint8_t) { return true; }
+		void clearDisplay(void) {}
+		void setTextSize(uint8_t) {}
+		void setTextColor(uint16_t) {}
+		void setCursor(int16_t, int16_t) {}
+		void display(void) {}
+		size_t write(const uint8_t *, size_t size) { return size; }
+		using Print::write;
+};
+
+#endif
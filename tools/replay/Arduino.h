@@ -0,0 +1,144 @@
+/*
+ *  Arduino core of the replay on a host
+ *
+ *  Enough of the core for platform.cpp and the sketches: String, the
+ *  serial ports, the pins and a virtual clock. Time only goes on when
+ *  the code waits: delay() jumps, and each call that polls the hardware
+ *  (millis(), micros(), digitalRead(), available()) takes REPLAY_POLL
+ *  microseconds, so busy loops end as they do on the board.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define	REPLAY_POLL	10	// us taken by a call that polls the hardware
+#define	REPLAY_I2C	500	// us of a read of the INA219
+#define	REPLAY_NODE	20	// ms the IoT node takes to answer on Serial1
+
+#define	HIGH		1
+#define	LOW		0
+#define	INPUT		0
+#define	OUTPUT		1
+#define	INPUT_PULLUP	2
+#define	DEC		10
+#define	HEX		16
+#define	A0		14
+#define	A1		15
+#define	A2		16
+#define	F(x)		(x)
+
+typedef uint8_t byte;
+
+//! Text of the Arduino core over std::string
+class String : public std::string {
+	public:
+		String(void) {}
+		String(const char *s) : std::string(s ? s : "") {}
+		String(const std::string &s) : std::string(s) {}
+		String(char c) : std::string(1, c) {}
+		String(int v, int base = DEC);
+		String(unsigned int v, int base = DEC);
+		String(long v, int base = DEC);
+		String(unsigned long v, int base = DEC);
+		String(double v, int decimals = 2);
+
+		float toFloat(void) const { return atof(c_str()); }
+		long toInt(void) const { return atol(c_str()); }
+		bool startsWith(const String &prefix) const { return compare(0, prefix.size(), prefix) == 0; }
+		String substring(unsigned from) const { return from < size() ? substr(from) : ""; }
+		String substring(unsigned from, unsigned to) const { return from < size() ? substr(from, to - from) : ""; }
+		int indexOf(char c) const { size_t i = find(c); return (i == npos) ? -1 : (int)i; }
+		void trim(void);
+};
+
+//! Output of the serial ports and the display
+class Print {
+	public:
+		virtual ~Print(void) {}
+		virtual size_t write(const uint8_t *buffer, size_t size);
+		size_t write(uint8_t c) { return write(&c, 1); }
+		size_t write(const char *s) { return write((const uint8_t*)s, strlen(s)); }
+
+		size_t print(const String &s) { return write((const uint8_t*)s.data(), s.size()); }
+		size_t print(const char *s) { return write(s); }
+		size_t print(char c) { return write((uint8_t)c); }
+		size_t print(int v, int base = DEC) { return print(String(v, base)); }
+		size_t print(unsigned int v, int base = DEC) { return print(String(v, base)); }
+		size_t print(long v, int base = DEC) { return print(String(v, base)); }
+		size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+		size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+		size_t println(void) { return write("\r\n"); }
+		template <typename T> size_t println(T v) { return print(v) + println(); }
+		template <typename T> size_t println(T v, int format) { return print(v, format) + println(); }
+};
+
+//! Input of the serial ports
+class Stream : public Print {
+	public:
+		virtual int available(void) { return 0; }
+		virtual int read(void) { return -1; }
+		virtual int peek(void) { return -1; }
+		virtual void flush(void) {}
+};
+
+//! Serial, the console: written to stderr with replay -v
+class consoleSerial : public Stream {
+	public:
+		bool verbose;
+
+		consoleSerial(void) : verbose(false) {}
+		void begin(unsigned long) {}
+		operator bool(void) { return true; }
+		size_t write(const uint8_t *buffer, size_t size);
+		using Print::write;
+};
+
+//! Serial1, the IoT node: it answers every question with a line after
+// REPLAY_NODE ms. The value is the one traced, replay.cpp gives it back
+class nodeSerial : public Stream {
+	uint64_t answered;		// us when the answer is complete
+	size_t next;			// character of the answer to read
+	public:
+		nodeSerial(void) : answered(0), next(0) {}
+		void begin(unsigned long) {}
+		operator bool(void) { return true; }
+		size_t write(const uint8_t *buffer, size_t size);
+		using Print::write;
+		int available(void);
+		int read(void);
+};
+
+extern consoleSerial Serial;
+extern nodeSerial Serial1;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis(void);
+unsigned long micros(void);
+void noInterrupts(void);
+void interrupts(void);
+
+//! Virtual clock of the replay, in us
+uint64_t replayClock(void);
+void replayAdvance(uint64_t us);
+
+// The sketch
+void setup(void);
+void loop(void);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ *  RadioHead RH_RF95 of the replay on a host
+ *
+ *  A packet sent keeps the radio busy for its time on air (airtime.h)
+ *  with the setting of the radio. The packets received are those of the
+ *  trace (TRACE_RECEIVE), each one available from the time it arrived
+ *  until the next one arrives, since the radio holds only one.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef RH_RF95_h
+#define RH_RF95_h
+
+#include <deque>
+#include <vector>
+#include "Arduino.h"
+
+#define	RH_RF95_MAX_MESSAGE_LEN	251
+#define	RH_RF95_HEADER_LEN	4	// bytes sent before the data: to, from, id and flags
+
+//! Packet of the trace, received at a time (us of the virtual clock)
+struct replayPacket {
+	uint64_t time;
+	int16_t rssi;
+	int8_t snr;
+	std::vector<uint8_t> data;
+};
+
+//! Packets sent in the replay
+struct replayRadioStats {
+	uint32_t sent, received, missed;
+	uint64_t bytes, airtime;	// us on air
+};
+
+class RH_RF95 {
+	uint8_t sf, cr;
+	uint32_t bandwidth;
+	uint64_t busy;			// us when the packet being sent ends
+	int16_t rssi;
+	int8_t snr;
+	std::deque<replayPacket> air;
+
+	//! Drops the packets that another one arriving overwrote
+	void arrive(void);
+	public:
+		replayRadioStats stats;
+
+		RH_RF95(uint8_t, uint8_t);
+		bool init(void) { return true; }
+		bool setFrequency(float) { return true; }
+		void setTxPower(int8_t, bool = false) {}
+		void setSpreadingFactor(uint8_t s) { sf = s; }
+		void setSignalBandwidth(long b) { bandwidth = b; }
+		void setCodingRate4(uint8_t denominator) { cr = denominator - 4; }
+
+		bool send(const uint8_t *data, uint8_t len);
+		bool waitPacketSent(void);
+		bool available(void);
+		bool waitAvailableTimeout(uint16_t timeout);
+		bool recv(uint8_t *buf, uint8_t *len);
+		int16_t lastRssi(void) { return rssi; }
+		int lastSNR(void) { return snr; }
+
+		//! Adds a packet of the trace
+		void receive(const replayPacket &packet) { air.push_back(packet); }
+};
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ *  RTClib of the replay on a host
+ *
+ *  The RTC tells the unix time of the start of the traced session plus
+ *  the time of the virtual clock since then.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef RTClib_h
+#define RTClib_h
+
+#include <time.h>
+#include "Arduino.h"
+
+class DateTime {
+	uint32_t t;
+	struct tm fields;
+	public:
+		DateTime(uint32_t unixtime = 0) : t(unixtime) { time_t s = t; gmtime_r(&s, &fields); }
+		DateTime(const char *date, const char *time);
+
+		uint16_t year(void) const { return fields.tm_year + 1900; }
+		uint8_t month(void) const { return fields.tm_mon + 1; }
+		uint8_t day(void) const { return fields.tm_mday; }
+		uint8_t hour(void) const { return fields.tm_hour; }
+		uint8_t minute(void) const { return fields.tm_min; }
+		uint8_t second(void) const { return fields.tm_sec; }
+		uint32_t unixtime(void) const { return t; }
+};
+
+class RTC_PCF8523 {
+	public:
+		bool begin(void) { return true; }
+		bool initialized(void) { return true; }
+		void adjust(const DateTime &) {}
+		DateTime now(void);
+};
+
+//! Unix time of the RTC when the virtual clock was at 0
+void replayRTC(uint32_t unixtime);
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ *  SD library of the replay on a host
+ *
+ *  The card is a directory of the host (replay -o), so what a sketch
+ *  writes in a replay can be read with the tools of tools/dataset.
+ *
+ *  Version 1.0
+ */
+
+
+// Ensure this library description is only included once
+#ifndef SD_h
+#define SD_h
+
+#include <memory>
+#include "Arduino.h"
+
+#define	O_READ		0x01
+#define	O_WRITE		0x02
+#define	O_RDWR		(O_READ | O_WRITE)
+#define	O_CREAT		0x04
+#define	O_APPEND	0x08
+#define	FILE_READ	O_READ
+#define	FILE_WRITE	(O_READ | O_WRITE | O_CREAT | O_APPEND)
+
+//! File of the card, shared by its copies as on the board
+class File : public Stream {
+	std::shared_ptr<FILE> f;
+	public:
+		File(void) {}
+		File(FILE *file) : f(file, fclose) {}
+
+		operator bool(void) { return (bool)f; }
+		void close(void) { f.reset(); }
+		bool seek(uint32_t position) { return f and (fseek(f.get(), position, SEEK_SET) == 0); }
+		uint32_t position(void) { return f ? ftell(f.get()) : 0; }
+		uint32_t size(void);
+		int available(void) { return f ? size() - position() : 0; }
+		int read(void) { return f ? fgetc(f.get()) : -1; }
+		int read(void *buffer, uint16_t length) { return f ? fread(buffer, 1, length, f.get()) : -1; }
+		int peek(void);
+		void flush(void) { if (f){ fflush(f.get()); } }
+		size_t write(const uint8_t *buffer, size_t size) { return f ? fwrite(buffer, 1, size, f.get()) : 0; }
+		using Print::write;
+};
+
+class SDClass {
+	public:
+		//! Directory of the card on the host
+		std::string root;
+
+		SDClass(void) : root(".") {}
+		bool begin(uint8_t) { return true; }
+		File open(const String &path, uint8_t mode = FILE_READ);
+		bool exists(const String &path);
+		bool remove(const String &path);
+};
+
+extern SDClass SD;
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ *  SPI of the replay on a host: the SD and the radio are emulated
+ *
+ *  Version 1.0
+ */
+
+#ifndef SPI_h
+#define SPI_h
+
+#include "Arduino.h"
+
+#endif
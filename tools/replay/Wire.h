@@ -0,0 +1,23 @@
+/*
+ *  Wire of the replay on a host: every I2C address answers, so the
+ *  INA219 and the display are found
+ *
+ *  Version 1.0
+ */
+
+#ifndef Wire_h
+#define Wire_h
+
+#include "Arduino.h"
+
+class TwoWire {
+	public:
+		void begin(void) {}
+		void setClock(uint32_t) {}
+		void beginTransmission(uint8_t) {}
+		uint8_t endTransmission(void) { return 0; }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,367 @@
+/*
+ *  Runtime of the Arduino core, SD, RTC and radio of the replay
+ *
+ *  Version 1.0
+ */
+
+#include <errno.h>
+#include <sys/stat.h>
+#include "Arduino.h"
+#include "SD.h"
+#include "RTClib.h"
+#include "RH_RF95.h"
+#include "Wire.h"
+#include "airtime.h"
+
+#define	SHT_DATA	A1	// pins of the SHT1x, as platform.cpp
+#define	SHT_CLOCK	A2
+#define	SHT_CONVERSION	80	// ms of a conversion of the SHT1x
+
+static uint64_t now = 0;	// us of the virtual clock
+static uint32_t rtcStart = 0;	// unix time at 0 us
+
+consoleSerial Serial;
+nodeSerial Serial1;
+SDClass SD;
+TwoWire Wire;
+
+//***************************************************************
+// Virtual clock						*
+//***************************************************************
+
+uint64_t replayClock(void)
+{
+	return now;
+}
+
+void replayAdvance(uint64_t us)
+{
+	now += us;
+}
+
+unsigned long millis(void)
+{
+	now += REPLAY_POLL;
+	return (uint32_t)(now / 1000);
+}
+
+unsigned long micros(void)
+{
+	now += REPLAY_POLL;
+	return (uint32_t)now;
+}
+
+void delay(unsigned long ms)
+{
+	now += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	now += us;
+}
+
+void noInterrupts(void)
+{
+}
+
+void interrupts(void)
+{
+}
+
+//***************************************************************
+// Pins: the data line of the SHT1x				*
+//***************************************************************
+
+//! Steps of a measurement of the SHT1x, as the sensor sees the lines
+enum shtPhase {
+	SHT_IDLE,
+	SHT_COMMAND,			// start sequence seen, command being clocked
+	SHT_ACK,			// data released by the host: pulled low at the ninth clock
+	SHT_CONVERTING			// data low once converted, then the bits (0)
+};
+
+static shtPhase sht = SHT_IDLE;
+static uint8_t shtClock = LOW;
+static uint64_t shtReady = 0;
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	if ((pin == SHT_DATA) and (mode == INPUT) and (sht == SHT_COMMAND)){
+		sht = SHT_ACK;
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin == SHT_CLOCK){
+		shtClock = value;
+	}else if ((pin == SHT_DATA) and (value == LOW) and (shtClock == HIGH)){
+		// Transmission start: data falls while the clock is high
+		sht = SHT_COMMAND;
+	}
+}
+
+int digitalRead(uint8_t pin)
+{
+	now += REPLAY_POLL;
+	if (pin != SHT_DATA){
+		return LOW;
+	}
+	switch (sht){
+		case SHT_ACK:
+			if (shtClock == HIGH){
+				return LOW;
+			}
+			sht = SHT_CONVERTING;
+			shtReady = now + SHT_CONVERSION * 1000;
+			return HIGH;
+		case SHT_CONVERTING:
+			return ((shtClock == HIGH) or (now >= shtReady)) ? LOW : HIGH;
+		default:
+			return HIGH;
+	}
+}
+
+int analogRead(uint8_t /* pin */)
+{
+	now += REPLAY_POLL;
+	return 0;
+}
+
+//***************************************************************
+// Serial ports							*
+//***************************************************************
+
+size_t Print::write(const uint8_t * /* buffer */, size_t size)
+{
+	return size;
+}
+
+size_t consoleSerial::write(const uint8_t *buffer, size_t size)
+{
+	if (verbose){
+		fwrite(buffer, 1, size, stderr);
+	}
+	return size;
+}
+
+static const char nodeAnswer[] = "0\n";
+
+size_t nodeSerial::write(const uint8_t *buffer, size_t size)
+{
+	// A question ends with a new line
+	if (size and (buffer[size - 1] == '\n')){
+		answered = now + REPLAY_NODE * 1000;
+		next = 0;
+	}
+	return size;
+}
+
+int nodeSerial::available(void)
+{
+	now += REPLAY_POLL;
+	if ((answered == 0) or (now < answered)){
+		return 0;
+	}
+	return sizeof(nodeAnswer) - 1 - next;
+}
+
+int nodeSerial::read(void)
+{
+	if (available() == 0){
+		return -1;
+	}
+	return nodeAnswer[next++];
+}
+
+//***************************************************************
+// String							*
+//***************************************************************
+
+static std::string number(unsigned long v, int base, bool negative)
+{
+	const char digits[] = "0123456789ABCDEF";
+	std::string s;
+
+	do {
+		s.insert(s.begin(), digits[v % base]);
+		v /= base;
+	} while (v);
+	return negative ? "-" + s : s;
+}
+
+String::String(int v, int base) : std::string(number((v < 0) ? -(long)v : v, base, v < 0)) {}
+String::String(unsigned int v, int base) : std::string(number(v, base, false)) {}
+String::String(long v, int base) : std::string(number((v < 0) ? -(unsigned long)v : v, base, v < 0)) {}
+String::String(unsigned long v, int base) : std::string(number(v, base, false)) {}
+
+String::String(double v, int decimals)
+{
+	char text[64];
+
+	snprintf(text, sizeof(text), "%.*f", decimals, v);
+	assign(text);
+}
+
+void String::trim(void)
+{
+	size_t first = find_first_not_of(" \t\r\n"), last = find_last_not_of(" \t\r\n");
+
+	assign((first == npos) ? "" : substr(first, last - first + 1));
+}
+
+//***************************************************************
+// SD								*
+//***************************************************************
+
+uint32_t File::size(void)
+{
+	struct stat st;
+
+	if (!f){
+		return 0;
+	}
+	fflush(f.get());
+	return (fstat(fileno(f.get()), &st) == 0) ? st.st_size : 0;
+}
+
+int File::peek(void)
+{
+	int c = read();
+
+	if (c >= 0){
+		ungetc(c, f.get());
+	}
+	return c;
+}
+
+File SDClass::open(const String &path, uint8_t mode)
+{
+	std::string host = root + "/" + path;
+	FILE *f;
+
+	if (!(mode & O_WRITE)){
+		return File(fopen(host.c_str(), "rb"));
+	}
+	if (mode & O_APPEND){
+		return File(fopen(host.c_str(), "a+b"));
+	}
+	// Read and write from the start, as the blocks of a log
+	f = fopen(host.c_str(), "r+b");
+	if (!f and (errno == ENOENT) and (mode & O_CREAT)){
+		f = fopen(host.c_str(), "w+b");
+	}
+	return File(f);
+}
+
+bool SDClass::exists(const String &path)
+{
+	struct stat st;
+
+	return stat((root + "/" + path).c_str(), &st) == 0;
+}
+
+bool SDClass::remove(const String &path)
+{
+	return ::remove((root + "/" + path).c_str()) == 0;
+}
+
+//***************************************************************
+// RTC								*
+//***************************************************************
+
+DateTime::DateTime(const char *date, const char *time)
+{
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	char month[4] = {0};
+
+	memset(&fields, 0, sizeof(fields));
+	sscanf(date, "%3s %d %d", month, &fields.tm_mday, &fields.tm_year);
+	sscanf(time, "%d:%d:%d", &fields.tm_hour, &fields.tm_min, &fields.tm_sec);
+	fields.tm_mon = (strstr(months, month) - months) / 3;
+	fields.tm_year -= 1900;
+	t = timegm(&fields);
+}
+
+DateTime RTC_PCF8523::now(void)
+{
+	return DateTime(rtcStart + ::now / 1000000);
+}
+
+void replayRTC(uint32_t unixtime)
+{
+	rtcStart = unixtime - now / 1000000;
+}
+
+//***************************************************************
+// Radio							*
+//***************************************************************
+
+RH_RF95::RH_RF95(uint8_t, uint8_t) : sf(7), cr(1), bandwidth(125000), busy(0), rssi(0), snr(0)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void RH_RF95::arrive(void)
+{
+	while ((air.size() > 1) and (air[1].time <= now)){
+		air.pop_front();
+		stats.missed++;
+	}
+}
+
+bool RH_RF95::send(const uint8_t * /* data */, uint8_t len)
+{
+	uint32_t onAir = loraAirtime(len + RH_RF95_HEADER_LEN, sf, bandwidth, cr);
+
+	waitPacketSent();
+	busy = now + onAir;
+	stats.sent++;
+	stats.bytes += len;
+	stats.airtime += onAir;
+	return true;
+}
+
+bool RH_RF95::waitPacketSent(void)
+{
+	if (now < busy){
+		now = busy;
+	}
+	return true;
+}
+
+bool RH_RF95::available(void)
+{
+	now += REPLAY_POLL;
+	arrive();
+	return !air.empty() and (air.front().time <= now);
+}
+
+bool RH_RF95::waitAvailableTimeout(uint16_t timeout)
+{
+	uint64_t end = now + (uint64_t)timeout * 1000;
+
+	arrive();
+	if (!air.empty() and (air.front().time <= end)){
+		now = (air.front().time > now) ? air.front().time : now;
+		return true;
+	}
+	now = end;
+	return false;
+}
+
+bool RH_RF95::recv(uint8_t *buf, uint8_t *len)
+{
+	if (!available()){
+		return false;
+	}
+	replayPacket &p = air.front();
+	*len = (p.data.size() < *len) ? p.data.size() : *len;
+	memcpy(buf, p.data.data(), *len);
+	rssi = p.rssi;
+	snr = p.snr;
+	air.pop_front();
+	stats.received++;
+	return true;
+}
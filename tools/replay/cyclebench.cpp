@@ -0,0 +1,124 @@
+/*
+ *  Cycle time of a sample on a host, one source after another and with
+ *  sample()
+ *
+ *  Runs platformClass over the virtual clock of the replay (arduino.cpp),
+ *  where every operation takes the time it takes on the board: the panel
+ *  settles PANEL_SETTLE ms after the relay, the IoT node answers each
+ *  question on Serial1 after REPLAY_NODE ms, a conversion of the SHT1x
+ *  lasts SHT_CONVERSION ms and a read of an INA219 REPLAY_I2C us. The
+ *  serial cycle calls the getters one after another, as sketches did
+ *  before sample(); the pipelined cycle is sample() with the same
+ *  sources. Both are run with the node (SAMPLE_TESTBED) and with the
+ *  local SHT1x in place of the node's temperature and humidity.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I. -I../../platform -o cyclebench cyclebench.cpp arduino.cpp \
+ *		../../platform/platform.cpp ../../platform/trace.cpp ../../platform/blocklog.cpp \
+ *		../../platform/tdma.cpp ../../platform/adr.cpp ../../platform/wind.cpp ../../platform/sampleQueue.cpp
+ *  Usage:
+ *	cyclebench [-n cycles]
+ *
+ *  Version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "platform.h"
+
+#define	SAMPLE_LOCAL	(SAMPLE_TIME|SAMPLE_PANEL|SAMPLE_LOAD|SAMPLE_BATTERY|SAMPLE_NODE|SAMPLE_CLIMATE)
+
+//! Virtual ms of a cycle: lowest, mean and highest
+struct cycleTime {
+	double low, mean, high;
+};
+
+//! The sources of a sample read one after another with the getters
+static void serialCycle(uint16_t sources)
+{
+	if (sources & SAMPLE_TIME){
+		platform.getTime();
+	}
+	if (sources & SAMPLE_PANEL){
+		platform.getPanelCurrent();
+		platform.getPanelPower();
+	}
+	if (sources & SAMPLE_LOAD){
+		platform.getLoadCurrent();
+		platform.getLoadPower();
+	}
+	if (sources & SAMPLE_BATTERY){
+		platform.getBatteryCurrent();
+		platform.getBatteryPower();
+	}
+	if (sources & SAMPLE_WIND){
+		platform.getSpeedOfWind();
+	}
+	if (sources & SAMPLE_CLIMATE){
+		platform.readTemperature();
+		platform.readHumidity();
+	}else if (sources & SAMPLE_NODE){
+		platform.getTemperature();
+		platform.getHumidity();
+	}
+	if (sources & SAMPLE_NODE){
+		platform.getBatteryVoltage();
+	}
+}
+
+//! Runs cycles of the sources, serially or with sample()
+static cycleTime measure(uint16_t sources, bool pipelined, int cycles)
+{
+	cycleTime c = {1e30, 0, 0};
+	Sample s;
+
+	for (int i = 0; i < cycles; i++){
+		uint64_t start = replayClock();
+		if (pipelined){
+			platform.sample(s, sources);
+		}else{
+			serialCycle(sources);
+		}
+		double ms = (replayClock() - start) / 1000.0;
+		c.low = (ms < c.low) ? ms : c.low;
+		c.high = (ms > c.high) ? ms : c.high;
+		c.mean += ms / cycles;
+	}
+	return c;
+}
+
+int main(int argc, char **argv)
+{
+	const struct {
+		const char *name;
+		uint16_t sources;
+	} sets[] = {{"node", SAMPLE_TESTBED}, {"local SHT1x", SAMPLE_LOCAL}};
+	int cycles = 100;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1){
+		switch (opt){
+			case 'n': cycles = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n cycles]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (cycles <= 0){
+		fprintf(stderr, "usage: %s [-n cycles]\n", argv[0]);
+		return 1;
+	}
+	platform.initialize(PERIPHERAL_RTC | PERIPHERAL_INA0 | PERIPHERAL_INA1 | PERIPHERAL_INA2);
+
+	printf("%d cycles, virtual ms: lowest / mean / highest\n", cycles);
+	printf("%-12s %24s %24s %8s\n", "sources", "serial", "sample()", "speedup");
+	for (const auto &set : sets){
+		cycleTime before = measure(set.sources, false, cycles);
+		cycleTime after = measure(set.sources, true, cycles);
+		printf("%-12s %8.1f %7.1f %7.1f %8.1f %7.1f %7.1f %7.2fx\n", set.name,
+				before.low, before.mean, before.high, after.low, after.mean, after.high,
+				before.mean / after.mean);
+	}
+	return 0;
+}
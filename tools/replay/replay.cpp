@@ -0,0 +1,258 @@
+/*
+ *  Replay of a trace of a node (platform/trace.h) on a host
+ *
+ *  Runs the sketch (sketch.cpp) and platformClass over a virtual clock,
+ *  as fast as the CPU allows, giving back to them what the hardware
+ *  read and the packets the radio received in a session of the trace.
+ *  A reading gives back the last value traced of its kind up to the
+ *  time of the clock, the radio receives each packet at the time it was
+ *  traced and a packet sent takes its time on air. The replay ends with
+ *  the session, and prints how far the replayed sketch and the traced
+ *  one agree: a change of the sketch or of the library that changes the
+ *  timing, the samples or the packets shows in the counts.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I. -I../../platform -o replay replay.cpp arduino.cpp sketch.cpp \
+ *		../../platform/platform.cpp ../../platform/trace.cpp ../../platform/blocklog.cpp \
+ *		../../platform/tdma.cpp ../../platform/adr.cpp ../../platform/wind.cpp ../../platform/sampleQueue.cpp
+ *  Usage:
+ *	replay [-s session] [-o sd directory] [-v] <trace>
+ *	replay -d <trace>		prints the records of every session
+ *
+ *  Version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <vector>
+#include "platform.h"
+#include "blocklog.h"
+#include "trace.h"
+
+extern RH_RF95 rf95;
+
+static const char *const kindNames[] = {"", "panelCurrent", "panelPower", "loadCurrent", "loadPower",
+	"batteryCurrent", "batteryPower", "temperature", "humidity", "nodeBattery", "batteryVoltage",
+	"wind", "shtTemperature", "shtHumidity"};
+
+//! Name of a kind of record
+static const char *kindName(uint8_t kind)
+{
+	switch (kind){
+		case TRACE_START: return "start";
+		case TRACE_SEND: return "send";
+		case TRACE_RECEIVE: return "receive";
+		case TRACE_SAMPLE: return "sample";
+	}
+	return (kind < TRACE_READINGS) ? kindNames[kind] : "?";
+}
+
+//! Records of a session, with their bytes
+struct session {
+	uint32_t unixtime;
+	std::vector<traceRecord> records;
+};
+
+//! Reads the valid blocks of a trace and splits its records in sessions
+static bool load(const char *path, std::vector<uint8_t> &bytes, std::vector<session> &sessions)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t block[LOG_BLOCK];
+	logHeader header;
+	std::vector<size_t> ends;
+
+	if (!f){
+		perror(path);
+		return false;
+	}
+	for (uint32_t i = 0; (fread(block, 1, LOG_BLOCK, f) == LOG_BLOCK) and blockLog::valid(block, i); i++){
+		memcpy(&header, block, sizeof(header));
+		bytes.insert(bytes.end(), block + sizeof(header), block + sizeof(header) + header.length);
+		ends.push_back(bytes.size());
+	}
+	fclose(f);
+	// Records never cross a block, and the time goes on across them
+	const uint8_t *p = bytes.data();
+	uint32_t time = 0;
+	traceRecord r;
+	for (size_t end : ends){
+		while (traceDecode(p, bytes.data() + end, time, r)){
+			if (r.kind == TRACE_START){
+				sessions.push_back(session());
+				if (r.length >= 9){
+					memcpy(&sessions.back().unixtime, r.data + 5, 4);
+				}
+			}
+			if (!sessions.empty()){
+				sessions.back().records.push_back(r);
+			}
+		}
+		p = bytes.data() + end;
+	}
+	return true;
+}
+
+//! Gives back the readings of a session and counts what the replay does
+class replayer : public traceBackend {
+	//! Readings of a kind and the next one to give back
+	struct series {
+		std::vector<const traceRecord*> records;
+		size_t next;
+	};
+	series readings[TRACE_READINGS];
+	public:
+		uint32_t replayed, measured;
+		uint32_t sends, receives, samples;
+
+		replayer(const session &s) : replayed(0), measured(0), sends(0), receives(0), samples(0)
+		{
+			for (series &k : readings){
+				k.next = 0;
+			}
+			for (const traceRecord &r : s.records){
+				if (r.kind < TRACE_READINGS){
+					readings[r.kind].records.push_back(&r);
+				}
+			}
+		}
+
+		void start(uint32_t) {}
+
+		float reading(uint8_t kind, float value)
+		{
+			uint32_t now = replayClock() / 1000;
+
+			if ((kind >= TRACE_READINGS) or readings[kind].records.empty()){
+				measured++;
+				return value;
+			}
+			series &k = readings[kind];
+			// The last value read up to now, or the first one
+			while ((k.next + 1 < k.records.size()) and (k.records[k.next + 1]->time <= now)){
+				k.next++;
+			}
+			replayed++;
+			return k.records[k.next]->value;
+		}
+
+		void event(uint8_t kind, uint32_t, const void *, uint8_t)
+		{
+			switch (kind){
+				case TRACE_SEND: sends++; break;
+				case TRACE_RECEIVE: receives++; break;
+				case TRACE_SAMPLE: samples++; break;
+			}
+		}
+};
+
+//! Prints the records of every session
+static void dump(const std::vector<session> &sessions)
+{
+	for (size_t s = 0; s < sessions.size(); s++){
+		printf("session %zu, unix time %u\n", s, sessions[s].unixtime);
+		for (const traceRecord &r : sessions[s].records){
+			printf("%10u %-15s", r.time, kindName(r.kind));
+			if (r.kind < TRACE_READINGS){
+				printf(" %g", r.value);
+			}else if ((r.kind == TRACE_SEND) and (r.length == 3)){
+				printf(" rate %u level %u bytes %u", r.data[0], r.data[1], r.data[2]);
+			}else if ((r.kind == TRACE_RECEIVE) and (r.length >= 3)){
+				int16_t rssi;
+				memcpy(&rssi, r.data, 2);
+				printf(" rssi %d snr %d bytes %u", rssi, (int8_t)r.data[2], r.length - 3);
+			}else if ((r.kind == TRACE_SAMPLE) and (r.length == 6)){
+				uint16_t valid;
+				uint32_t cycle;
+				memcpy(&valid, r.data, 2);
+				memcpy(&cycle, r.data + 2, 4);
+				printf(" valid 0x%04x cycle %u ms", valid, cycle);
+			}
+			printf("\n");
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<uint8_t> bytes;
+	std::vector<session> sessions;
+	unsigned index = 0;
+	bool print = false;
+	int opt;
+
+	SD.root = "replay-sd";
+	while ((opt = getopt(argc, argv, "s:o:vd")) != -1){
+		switch (opt){
+			case 's': index = atoi(optarg); break;
+			case 'o': SD.root = optarg; break;
+			case 'v': Serial.verbose = true; break;
+			case 'd': print = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-s session] [-o sd directory] [-v] [-d] <trace>\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind + 1 != argc){
+		fprintf(stderr, "usage: %s [-s session] [-o sd directory] [-v] [-d] <trace>\n", argv[0]);
+		return 1;
+	}
+	if (!load(argv[optind], bytes, sessions)){
+		return 1;
+	}
+	if (print){
+		dump(sessions);
+		return 0;
+	}
+	if (index >= sessions.size()){
+		fprintf(stderr, "%s: %zu sessions in the trace\n", argv[0], sessions.size());
+		return 1;
+	}
+	mkdir(SD.root.c_str(), 0755);
+
+	// The clock starts where the session did, so the times of the records are those of the replay
+	const session &s = sessions[index];
+	const uint32_t first = s.records.front().time, last = s.records.back().time;
+	uint32_t traced[3] = {0, 0, 0};
+	replayer r(s);
+	replayAdvance((uint64_t)first * 1000);
+	replayRTC(s.unixtime);
+	for (const traceRecord &t : s.records){
+		if ((t.kind == TRACE_RECEIVE) and (t.length >= 3)){
+			replayPacket p;
+			p.time = (uint64_t)t.time * 1000;
+			memcpy(&p.rssi, t.data, 2);
+			p.snr = t.data[2];
+			p.data.assign(t.data + 3, t.data + t.length);
+			rf95.receive(p);
+		}
+		traced[0] += (t.kind == TRACE_SEND);
+		traced[1] += (t.kind == TRACE_RECEIVE);
+		traced[2] += (t.kind == TRACE_SAMPLE);
+	}
+	platform.setTracer(&r);
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned long loops = 0;
+	setup();
+	while (replayClock() / 1000 < last){
+		loop();
+		loops++;
+	}
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double virtual_ = (replayClock() / 1000 - first) / 1000.0;
+
+	printf("session %u: %zu records, %.1f h replayed in %.3f s (%.0fx)\n", index, s.records.size(),
+			virtual_ / 3600, wall, virtual_ / wall);
+	printf("%lu loops, readings %u replayed and %u measured\n", loops, r.replayed, r.measured);
+	printf("%-10s %8s %8s\n", "", "traced", "replayed");
+	printf("%-10s %8u %8u\n", "samples", traced[2], r.samples);
+	printf("%-10s %8u %8u\n", "sent", traced[0], r.sends);
+	printf("%-10s %8u %8u (%u overwritten)\n", "received", traced[1], r.receives, rf95.stats.missed);
+	printf("airtime %.1f s of %u packets, %llu bytes\n", rf95.stats.airtime / 1e6, rf95.stats.sent,
+			(unsigned long long)rf95.stats.bytes);
+	return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ *  Sketch of a node of the testbed, as replayed by default
+ *
+ *  It samples every PERIOD ms, writes the sample to the log and sends
+ *  it. With TDMA a sample out of the slot of the node is kept by the
+ *  library, and the sketch wakes up in the slot to send it before the
+ *  next sample. On the board it traces the session in TRACE.LOG; in a
+ *  replay the tracer is already the replay, so startTrace() fails and
+ *  the values come from the trace. Replace this file to replay another
+ *  sketch.
+ *
+ *  Version 1.0
+ */
+
+#include "platform.h"
+
+#define	NODE		1
+#define	PERIOD		60000	// ms between samples
+
+void setup(void)
+{
+	Serial.begin(9600);
+	platform.initialize(PERIPHERAL_SD | PERIPHERAL_RTC | PERIPHERAL_LORA);
+	platform.setNodeId(NODE);
+	platform.startTrace("TRACE.LOG");
+	platform.open("DATA.LOG", 0);	// WRITE
+}
+
+void loop(void)
+{
+	Sample s;
+	unsigned long start = millis();
+	uint32_t wait;
+
+	platform.sample(s, SAMPLE_TESTBED);
+	platform.writeSample(s);
+	if (platform.sendSample(s) == LORA_WAIT){
+		// Out of the slot: send it when the slot comes, if before the next sample
+		wait = platform.getSlotWait();
+		if (wait < PERIOD - (millis() - start) % PERIOD){
+			delay(wait);
+			platform.sendPending();
+		}
+	}
+	delay(PERIOD - (millis() - start) % PERIOD);
+}
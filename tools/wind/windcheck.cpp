@@ -0,0 +1,176 @@
+/*
+ *  Check of the background capture of the anenometer (platform/wind.h)
+ *  on a host
+ *
+ *  A simulated timer ticks rate times per second and feeds windCapture
+ *  the ADC reading of the trace at each tick, as TC3_Handler() does with
+ *  analogRead(). Every period, as getWindStats() would, the totals are
+ *  taken and compared with the ones computed again from every reading:
+ *  count, sum, sum of squares, lowest and highest reading, and the gust,
+ *  the highest sum of gust * rate consecutive readings ending in the
+ *  period. Any difference is printed and the exit status is 1.
+ *
+ *  The trace is a text file with a line "<ms> <reading>" per change of
+ *  the analog output of the anenometer (0 - 1023), in order of time.
+ *  Without a trace, one of gusty wind is generated.
+ *
+ *  Build:
+ *	g++ -O2 -std=c++17 -I../../platform -o windcheck windcheck.cpp ../../platform/wind.cpp
+ *  Usage:
+ *	windcheck [-r rate Hz] [-g gust s] [-p period s] [-t hours] [-v] [trace]
+ *
+ *  Version 1.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+#include "wind.h"
+
+#define	AUX1		(3.3/1023)	// as platform.cpp
+#define	AUX2		(32.4/1.6)
+#define	WIND_SPEED(x)	(((AUX1*(x))-0.4)*AUX2)
+#define	WIND_READING(v)	(((v)/AUX2+0.4)/AUX1)
+
+//! Change of the analog output of the anenometer
+struct change {
+	uint64_t ms;
+	uint16_t reading;
+};
+
+//! Reads a trace of "<ms> <reading>" lines
+static bool load(const char *path, std::vector<change> &trace)
+{
+	FILE *f = fopen(path, "r");
+	unsigned long long ms;
+	unsigned reading;
+
+	if (!f){
+		perror(path);
+		return false;
+	}
+	while (fscanf(f, "%llu %u", &ms, &reading) == 2){
+		if ((!trace.empty() and (ms < trace.back().ms)) or (reading > 1023)){
+			fprintf(stderr, "%s: line %zu out of order or range\n", path, trace.size() + 1);
+			fclose(f);
+			return false;
+		}
+		trace.push_back({ms, (uint16_t)reading});
+	}
+	fclose(f);
+	return !trace.empty();
+}
+
+//! Gusty wind: a mean that drifts over the hours and gusts of a few seconds, every 100 ms
+static void generate(double hours, std::vector<change> &trace)
+{
+	std::mt19937 rng(2019);
+	std::normal_distribution<double> noise(0.0, 1.0);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	double gust = 0;
+
+	for (uint64_t ms = 0; ms < hours * 3600000; ms += 100){
+		double mean = 6 + 4 * sin(2 * M_PI * ms / 3600000.0 / 6);
+		if (uniform(rng) < 0.002){
+			gust = 4 + 8 * uniform(rng);
+		}
+		gust *= 0.97;
+		double v = mean + gust + 1.5 * noise(rng);
+		double reading = WIND_READING(v > 0 ? v : 0);
+		trace.push_back({ms, (uint16_t)(reading > 1023 ? 1023 : reading)});
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<change> trace;
+	std::vector<uint16_t> readings;
+	unsigned rate = 10, gust = 3, period = 60;
+	double hours = 24;
+	bool verbose = false;
+	unsigned long periods = 0, errors = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:g:p:t:v")) != -1){
+		switch (opt){
+			case 'r': rate = atoi(optarg); break;
+			case 'g': gust = atoi(optarg); break;
+			case 'p': period = atoi(optarg); break;
+			case 't': hours = atof(optarg); break;
+			case 'v': verbose = true; break;
+			default: optind = argc + 1;
+		}
+	}
+	if ((optind > argc) or (optind + 1 < argc) or (rate == 0) or (period == 0) or
+			(gust * rate == 0) or (gust * rate >= WIND_BUFFER)){
+		fprintf(stderr, "usage: %s [-r rate Hz] [-g gust s] [-p period s] [-t hours] [-v] [trace]\n", argv[0]);
+		fprintf(stderr, "       gust * rate between 1 and %d readings\n", WIND_BUFFER - 1);
+		return 1;
+	}
+	if (optind < argc){
+		if (!load(argv[optind], trace)){
+			return 1;
+		}
+	}else{
+		generate(hours, trace);
+	}
+
+	windCapture capture(gust * rate);
+	const unsigned window = gust * rate;
+	const uint64_t end = trace.back().ms;
+	size_t next = 0, first = 0;
+
+	// The timer ticks at k / rate s; each tick reads the last change of the trace
+	for (uint64_t tick = 0; tick * 1000 / rate <= end; tick++){
+		uint64_t ms = tick * 1000 / rate;
+		while ((next + 1 < trace.size()) and (trace[next + 1].ms <= ms)){
+			next++;
+		}
+		capture.add(trace[next].reading);
+		readings.push_back(trace[next].reading);
+		if ((tick + 1) % (period * rate) != 0){
+			continue;
+		}
+
+		// getWindStats(): what the capture took against every reading of the period
+		windTotals t, want = {0, 0, 0, 0xFFFF, 0, 0, (uint8_t)window};
+		capture.take(t);
+		for (size_t i = first; i < readings.size(); i++){
+			want.count++;
+			want.sum += readings[i];
+			want.squares += (uint32_t)readings[i] * readings[i];
+			want.low = (readings[i] < want.low) ? readings[i] : want.low;
+			want.high = (readings[i] > want.high) ? readings[i] : want.high;
+			if (i + 1 >= window){
+				uint32_t sum = 0;
+				for (size_t j = i + 1 - window; j <= i; j++){
+					sum += readings[j];
+				}
+				want.gust = (sum > want.gust) ? sum : want.gust;
+			}
+		}
+		first = readings.size();
+		periods++;
+		if ((t.count != want.count) or (t.sum != want.sum) or (t.squares != want.squares) or
+				(t.low != want.low) or (t.high != want.high) or (t.gust != want.gust) or
+				(t.gustSamples != want.gustSamples) or (capture.last() != readings.back())){
+			printf("%8llu s: count %u/%u sum %u/%u squares %llu/%llu low %u/%u high %u/%u gust %u/%u\n",
+				(unsigned long long)(ms / 1000), t.count, want.count, t.sum, want.sum,
+				(unsigned long long)t.squares, (unsigned long long)want.squares,
+				t.low, want.low, t.high, want.high, t.gust, want.gust);
+			errors++;
+		}else if (verbose){
+			double mean = (double)t.sum / t.count;
+			printf("%8llu s: mean %5.2f m/s, gust %5.2f m/s, lowest %5.2f, highest %5.2f\n",
+				(unsigned long long)(ms / 1000), WIND_SPEED(mean),
+				t.gust ? WIND_SPEED((double)t.gust / t.gustSamples) : NAN,
+				WIND_SPEED(t.low), WIND_SPEED(t.high));
+		}
+	}
+	printf("%zu readings at %u Hz, %lu periods of %u s, gust over %u readings: %lu wrong\n",
+		readings.size(), rate, periods, period, window, errors);
+	return errors ? 1 : 0;
+}